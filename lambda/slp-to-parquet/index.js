@@ -1,4 +1,3 @@
-const fs = require('fs').promises;
 const path = require('path');
 const { S3Client, GetObjectCommand, PutObjectCommand } = require('@aws-sdk/client-s3');
 const { execFile } = require('child_process');
@@ -32,14 +31,16 @@ async function sendFilesToS3( startAt, sourceBucket, destinationBucket, streams
   }
 }
 
-function parseWithSlippc(fileName, outputPath) {
+function parseWithSlippc(buffer, fileName, outputPath) {
   const slippcPath = '/opt/bin/slippc';  // Path to slippc binary in Lambda layer
 
   return new Promise((resolve, reject) => {
-    execFile(
+    // Replay bytes are piped through stdin so they never touch /tmp
+    const child = execFile(
         slippcPath,
         [
-          '-i', fileName,
+          '-i', '-',
+          '-n', fileName,
           '-j', outputPath,
           '-a', outputPath + '/analysis.json',
           '-f',
@@ -62,6 +63,8 @@ function parseWithSlippc(fileName, outputPath) {
           });
         }
     );
+    child.stdin.on('error', reject);
+    child.stdin.end(buffer);
   });
 }
 
@@ -70,16 +73,13 @@ exports.handler = async (event) => {
   const bucket = record.s3.bucket.name;
   const key = decodeURIComponent(record.s3.object.key.replace(/\+/g, ' '));
   const fileName = path.basename(key);
-  const tempPath = path.join('/tmp', fileName);
+  let buffer;
 
   try {
     console.log('Retrieving SLP file from S3:', key);
     const command = new GetObjectCommand({ Bucket: bucket, Key: key });
     const response = await s3.send(command);
-    const buffer = await streamToBuffer(response.Body);
-
-    console.log('Writing SLP file to /tmp');
-    await fs.writeFile(tempPath, buffer);
+    buffer = await streamToBuffer(response.Body);
 
   } catch (err) {
     console.log('Error retrieving SLP file from S3:', err);
@@ -88,7 +88,7 @@ exports.handler = async (event) => {
   try {
     console.log('Parsing SLP file into JSON');
 
-    await parseWithSlippc(fileName, '/tmp');
+    await parseWithSlippc(buffer, fileName, '/tmp');
     console.log('Slippc Done!');
 
   } catch (err) {
@@ -107,6 +107,7 @@ exports.handler = async (event) => {
       { key: 'items', type: 'parquet' },
       { key: 'attacks', type: 'parquet' },
       { key: 'punishes', type: 'parquet' },
+      { key: 'dynamics', type: 'parquet' },
       { key: 'match-settings', type: 'jsonl' },
       { key: 'player-settings', type: 'jsonl' },
     ];
@@ -127,6 +127,19 @@ export class GlueStack extends cdk.Stack {
     );
     punishesTable.addDependency(this.glueDb);
 
+    // Add dynamics table
+    const dynamicsSchema = loadGlueSchema('schemas/glue/dynamics-schema.json');
+    const dynamicsTable = createGlueTableWithLocation(
+      this,
+      'aparoid-dynamics-table',
+      dynamicsSchema,
+      this.glueDb.ref,
+      `s3://${props.processedDataBucketName}`,
+      'dynamics',
+      'parquet'  // Note: dynamics are output as Parquet from slippc
+    );
+    dynamicsTable.addDependency(this.glueDb);
+
     // Remove all code related to Glue/Athena view creation, Lambda, and custom resource
     // Only keep Glue tables and database logic
 
@@ -168,7 +168,7 @@ std::string Analysis::attacksAsJson() {
   int a = 1;
 
   for(unsigned p = 0; p < 2; ++p) {
-    for(unsigned i = 0; ap[p].attacks[i].frame > 0; ++i) {
+    for(unsigned i = 0; i < ap[p].attacks.size(); ++i) {
       ss << "{";
       ss << JLSTR("match_id",        game_time);
       ss << JLEND(a) << JLSTR("player_id",       ap[p].tag_code);
@@ -190,7 +190,13 @@ std::string Analysis::attacksAsJson() {
   return ss.str();
 }
 
-arrow::Status Analysis::attacksAsParquet() {
+arrow::Status Analysis::attacksAsParquet(const OutputSink& sink, const ParquetOptions& o) {
+  ParquetAppender out(sink,"attacks",o);
+  ARROW_RETURN_NOT_OK(attacksAsParquet(out));
+  return out.close();
+}
+
+arrow::Status Analysis::attacksAsParquet(ParquetAppender& out) {
 
   using arrow::FloatBuilder;
   using arrow::UInt8Builder;
@@ -222,7 +228,7 @@ arrow::Status Analysis::attacksAsParquet() {
   FloatBuilder damage_b;
 
   for(unsigned p = 0; p < 2; ++p) {
-    for(unsigned i = 0; ap[p].attacks[i].frame > 0; ++i) {
+    for(unsigned i = 0; i < ap[p].attacks.size(); ++i) {
       match_id_b.Append(game_time);
       player_id_b.Append(ap[p].tag_code);
       attack_id_b.Append(i);
@@ -264,34 +270,7 @@ arrow::Status Analysis::attacksAsParquet() {
     hit_id_a, anim_frame_a, damage_a, opening_a, kill_dir_a
   });
 
-  try {
-    std::shared_ptr<arrow::io::FileOutputStream> outfile;
-    PARQUET_ASSIGN_OR_THROW(outfile, arrow::io::FileOutputStream::Open("/tmp/attacks.parquet"));
-
-    std::shared_ptr<arrow::io::OutputStream> outstream =
-      std::static_pointer_cast<arrow::io::OutputStream>(outfile);
-
-    // TODO: switch from to snappy
-    std::shared_ptr<parquet::WriterProperties> writer_properties =
-      parquet::WriterProperties::Builder()
-        .compression(parquet::Compression::UNCOMPRESSED)
-        ->build();
-
-    PARQUET_THROW_NOT_OK(
-      parquet::arrow::WriteTable(*table, arrow::default_memory_pool(), outstream, 1024, writer_properties)
-    );
-  } catch (const parquet::ParquetException& e) {
-    std::cerr << "[ParquetException] " << e.what() << std::endl;
-    return arrow::Status::ExecutionError("ParquetException: ", e.what());
-  } catch (const std::exception& e) {
-    std::cerr << "[std::exception] " << e.what() << std::endl;
-    return arrow::Status::ExecutionError("std::exception: ", e.what());
-  } catch (...) {
-    std::cerr << "[Unknown error] during Parquet file write." << std::endl;
-    return arrow::Status::ExecutionError("Unknown error during Parquet write");
-  }
-
-  return arrow::Status::OK();
+  return out.append(*table);
 }
 
 std::string Analysis::punishesAsJson() {
@@ -299,7 +278,7 @@ std::string Analysis::punishesAsJson() {
   int a = 1;
 
   for(unsigned p = 0; p < 2; ++p) {
-    for(unsigned i = 0; ap[p].punishes[i].num_moves > 0; ++i) {
+    for(unsigned i = 0; i < ap[p].punishes.size(); ++i) {
       ss << "{";
       ss << JLSTR("match_id",        game_time);
       ss << JLEND(a) << JLSTR("player_id",       ap[p].tag_code);
@@ -319,7 +298,13 @@ std::string Analysis::punishesAsJson() {
   return ss.str();
 }
 
-arrow::Status Analysis::punishesAsParquet() {
+arrow::Status Analysis::punishesAsParquet(const OutputSink& sink, const ParquetOptions& o) {
+  ParquetAppender out(sink,"punishes",o);
+  ARROW_RETURN_NOT_OK(punishesAsParquet(out));
+  return out.close();
+}
+
+arrow::Status Analysis::punishesAsParquet(ParquetAppender& out) {
 
   using arrow::FloatBuilder;
   using arrow::UInt8Builder;
@@ -347,7 +332,7 @@ arrow::Status Analysis::punishesAsParquet() {
   FloatBuilder start_pct_b, end_pct_b;
 
   for(unsigned p = 0; p < 2; ++p) {
-    for(unsigned i = 0; ap[p].attacks[i].frame > 0; ++i) {
+    for(unsigned i = 0; i < ap[p].punishes.size(); ++i) {
       match_id_b.Append(game_time);
       player_id_b.Append(ap[p].tag_code);
       start_frame_b.Append(ap[p].punishes[i].start_frame);
@@ -380,34 +365,64 @@ arrow::Status Analysis::punishesAsParquet() {
     stocks_a, num_moves_a, last_move_id_a, kill_dir_a
   });
 
-  try {
-    std::shared_ptr<arrow::io::FileOutputStream> outfile;
-    PARQUET_ASSIGN_OR_THROW(outfile, arrow::io::FileOutputStream::Open("/tmp/punishes.parquet"));
-
-    std::shared_ptr<arrow::io::OutputStream> outstream =
-      std::static_pointer_cast<arrow::io::OutputStream>(outfile);
-
-    // TODO: switch from to snappy
-    std::shared_ptr<parquet::WriterProperties> writer_properties =
-      parquet::WriterProperties::Builder()
-        .compression(parquet::Compression::UNCOMPRESSED)
-        ->build();
-
-    PARQUET_THROW_NOT_OK(
-      parquet::arrow::WriteTable(*table, arrow::default_memory_pool(), outstream, 1024, writer_properties)
-    );
-  } catch (const parquet::ParquetException& e) {
-    std::cerr << "[ParquetException] " << e.what() << std::endl;
-    return arrow::Status::ExecutionError("ParquetException: ", e.what());
-  } catch (const std::exception& e) {
-    std::cerr << "[std::exception] " << e.what() << std::endl;
-    return arrow::Status::ExecutionError("std::exception: ", e.what());
-  } catch (...) {
-    std::cerr << "[Unknown error] during Parquet file write." << std::endl;
-    return arrow::Status::ExecutionError("Unknown error during Parquet write");
+  return out.append(*table);
+}
+
+arrow::Status Analysis::dynamicsAsParquet(const OutputSink& sink, const ParquetOptions& o) {
+  ParquetAppender out(sink,"dynamics",o);
+  ARROW_RETURN_NOT_OK(dynamicsAsParquet(out));
+  return out.close();
+}
+
+arrow::Status Analysis::dynamicsAsParquet(ParquetAppender& out) {
+
+  using arrow::UInt8Builder;
+  using arrow::UInt32Builder;
+  using arrow::StringBuilder;
+
+  //One row per run of frames per player, so queries can join on frame ranges instead of scanning frames
+  std::shared_ptr<arrow::Schema> schema = arrow::schema({
+    arrow::field("match_id", arrow::utf8()),
+    arrow::field("player_id", arrow::utf8()),
+    arrow::field("interval_id", arrow::uint32()),
+    arrow::field("start_frame", arrow::uint32()),
+    arrow::field("end_frame", arrow::uint32()),
+    arrow::field("dynamic", arrow::uint8()),
+    arrow::field("dynamic_name", arrow::utf8()),
+  });
+
+  UInt8Builder dynamic_b;
+  UInt32Builder interval_id_b, start_frame_b, end_frame_b;
+  StringBuilder match_id_b, player_id_b, dynamic_name_b;
+
+  for(unsigned p = 0; p < 2; ++p) {
+    for(unsigned i = 0; i < dyn_intervals.size(); ++i) {
+      unsigned d = dynamicFor(dyn_intervals[i].dynamic,p);
+      match_id_b.Append(game_time);
+      player_id_b.Append(ap[p].tag_code);
+      interval_id_b.Append(i);
+      start_frame_b.Append(dyn_intervals[i].start);
+      end_frame_b.Append(dyn_intervals[i].end-1);  //Last frame of the run, as with punishes
+      dynamic_b.Append(d);
+      dynamic_name_b.Append(Dynamic::name[d]);
+    }
   }
 
-  return arrow::Status::OK();
+  std::shared_ptr<arrow::Array> match_id_a, player_id_a, interval_id_a, start_frame_a, end_frame_a, dynamic_a, dynamic_name_a;
+
+  match_id_b.Finish(&match_id_a);
+  player_id_b.Finish(&player_id_a);
+  interval_id_b.Finish(&interval_id_a);
+  start_frame_b.Finish(&start_frame_a);
+  end_frame_b.Finish(&end_frame_a);
+  dynamic_b.Finish(&dynamic_a);
+  dynamic_name_b.Finish(&dynamic_name_a);
+
+  std::shared_ptr<arrow::Table> table = arrow::Table::Make(schema, {
+    match_id_a, player_id_a, interval_id_a, start_frame_a, end_frame_a, dynamic_a, dynamic_name_a
+  });
+
+  return out.append(*table);
 }
 
 std::string Analysis::asJson() {
@@ -546,7 +561,7 @@ std::string Analysis::asJson() {
     ss << SPACE[ILEV] << "},\n";
 
     ss << SPACE[ILEV] << "\"attacks\" : [\n";
-    for(unsigned i = 0; ap[p].attacks[i].frame > 0; ++i) {
+    for(unsigned i = 0; i < ap[p].attacks.size(); ++i) {
       ss << SPACE[2*ILEV] << "{" << std::endl;
       ss << JUIN(2,"move_id",         ap[p].attacks[i].move_id)                        << ",\n";
       ss << JSTR(2,"move_name",       Move::shortname[ap[p].attacks[i].move_id])       << ",\n";
@@ -559,12 +574,12 @@ std::string Analysis::asJson() {
       ss << JFLT(2,"damage",          ap[p].attacks[i].damage)                         << ",\n";
       ss << JSTR(2,"opening",         Dynamic::name[ap[p].attacks[i].opening])         << ",\n";
       ss << JSTR(2,"kill_dir",        Dir::name[ap[p].attacks[i].kill_dir])            << "\n";
-      ss << SPACE[2*ILEV] << "}" << ((ap[p].attacks[i+1].frame > 0) ? ",\n" : "\n");
+      ss << SPACE[2*ILEV] << "}" << ((i+1 < ap[p].attacks.size()) ? ",\n" : "\n");
     }
     ss << SPACE[ILEV] << "],\n";
 
     ss << SPACE[ILEV] << "\"punishes\" : [\n";
-    for(unsigned i = 0; ap[p].punishes[i].num_moves > 0; ++i) {
+    for(unsigned i = 0; i < ap[p].punishes.size(); ++i) {
       ss << SPACE[2*ILEV] << "{" << std::endl;
       ss << JUIN(2,"start_frame",     ap[p].punishes[i].start_frame)                   << ",\n";
       ss << JUIN(2,"end_frame",       ap[p].punishes[i].end_frame)                     << ",\n";
@@ -576,7 +591,7 @@ std::string Analysis::asJson() {
       ss << JSTR(2,"last_move_name",  Move::shortname[ap[p].punishes[i].last_move_id]) << ",\n";
       ss << JSTR(2,"opening",         "UNUSED")                                        << ",\n";
       ss << JSTR(2,"kill_dir",        Dir::name[ap[p].punishes[i].kill_dir])           << "\n";
-      ss << SPACE[2*ILEV] << "}" << ((ap[p].punishes[i+1].num_moves > 0) ? ",\n" : "\n");
+      ss << SPACE[2*ILEV] << "}" << ((i+1 < ap[p].punishes.size()) ? ",\n" : "\n");
     }
     ss << SPACE[ILEV] << "]\n";
 
@@ -587,19 +602,16 @@ std::string Analysis::asJson() {
   return ss.str();
 }
 
-void Analysis::save(const char* outfilename) {
+void Analysis::save(const OutputSink& sink, const ParquetOptions& o, ParquetBatch* batch) {
 //   std::ofstream fout;
 //   fout.open(outfilename);
 //   std::string j = asJson();
 //   fout << j << std::endl;
 //   fout.close();
-  std::string fileNameWithPath = "/tmp/" + std::string(outfilename);
-  std::string statsFileName = fileNameWithPath + "/stats.json";
-  std::ofstream fout2;
-  fout2.open(statsFileName.c_str());
-  std::string j = statsAsJson();
-  fout2 << j << std::endl;
-  fout2.close();
+  arrow::Status status = sink.writeText("stats.json", statsAsJson() + "\n");
+  if (!status.ok()) {
+    std::cerr << "Error writing stats: " << status.ToString() << std::endl;
+  }
 
 //   std::string attacksFileName = std::string(outfilename) + "/attacks.jsonl";
 //   std::ofstream fout3;
@@ -615,8 +627,15 @@ void Analysis::save(const char* outfilename) {
 //   fout4 << l << std::endl;
 //   fout4.close();
 
-  attacksAsParquet();
-  punishesAsParquet();
+  if (batch) {
+    attacksAsParquet(batch->attacks);
+    punishesAsParquet(batch->punishes);
+    dynamicsAsParquet(batch->dynamics);
+    return;
+  }
+  attacksAsParquet(sink, o);
+  punishesAsParquet(sink, o);
+  dynamicsAsParquet(sink, o);
 }
 
 }
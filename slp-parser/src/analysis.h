@@ -2,17 +2,17 @@
 #ifndef ANALYSIS_H_
 #define ANALYSIS_H_
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <unistd.h>  //usleep
 #include <math.h>    //sqrt
+#include <vector>
 #include <arrow/status.h>
 
 #include "enums.h"
 #include "util.h"
-
-const unsigned MAX_ATTACKS   = 65535;    //Maximum number of attacks per player per game (increase later if needed)
-const unsigned MAX_PUNISHES  = 65535;    //Maximum number of punishes per player per game (increase later if needed)
+#include "writer.h"
 
 namespace slip {
 
@@ -42,8 +42,8 @@ struct Punish {
   uint8_t  kill_dir     = 0;  //Direction of kill, as specified in Dir enum (-1 = didn't kill)
 };
 
-//Struct for holding analysis data for a particular player within a game
-struct AnalysisPlayer {
+//Per-player statistics, kept apart from AnalysisPlayer's arrays so they can be reset by assignment
+struct AnalysisPlayerStats {
   unsigned     port                   =  0;  //0-indexed port number of the player (0-3 are valid)
   std::string  tag_player             =  ""; //Tag of the player as recorded in the game metadata
   std::string  tag_css                =  ""; //Tag of the player as chosen on the char. select screen
@@ -134,27 +134,45 @@ struct AnalysisPlayer {
   float        actionability          =  0;  //Mean actionability based on act out of stun and wait
   float        neutral_wins_per_min   =  0;  //Number of times we won neutral per minute spent in neutral
   float        mean_death_percent     =  0;  //Average damage received before losing a stock
+};
 
+//Run of consecutive frames over which a single interaction dynamic was in effect
+struct DynamicInterval {
+  unsigned start   = 0;  //First frame of the run (0 == internal frame -123)
+  unsigned end     = 0;  //One past the last frame of the run
+  unsigned dynamic = 0;  //Dynamic in effect, from the perspective of the lower port player
+};
+
+//Struct for holding analysis data for a particular player within a game
+struct AnalysisPlayer : AnalysisPlayerStats {
   unsigned*    move_counts;                  //Counts for each move the player landed
   unsigned*    dyn_counts;                   //Frame counts for player interaction dynamics
   float*       dyn_damage;                   //Damage done during each player interaction dynamic
-  Attack*      attacks;                      //List of all attacks we connected with throughout the game
-  Punish*      punishes;                     //List of all punishes we performed throughout the game
+  std::vector<Attack> attacks;               //List of all attacks we connected with throughout the game
+  std::vector<Punish> punishes;              //List of all punishes we performed throughout the game
 
   AnalysisPlayer() {
     move_counts = new unsigned[Move::__LAST]{0};
     dyn_counts  = new unsigned[Dynamic::__LAST]{0};
     dyn_damage  = new float[Dynamic::__LAST]{0};
-    attacks     = new Attack[MAX_ATTACKS];
-    punishes    = new Punish[MAX_PUNISHES];
   }
   ~AnalysisPlayer() {
-    delete [] punishes;
-    delete [] attacks;
     delete [] dyn_damage;
     delete [] dyn_counts;
     delete [] move_counts;
   }
+  AnalysisPlayer(const AnalysisPlayer&) = delete;
+  AnalysisPlayer& operator=(const AnalysisPlayer&) = delete;
+
+  //Return to a freshly constructed state without reallocating any arrays
+  void reset() {
+    static_cast<AnalysisPlayerStats&>(*this) = AnalysisPlayerStats();
+    std::fill(move_counts, move_counts+Move::__LAST,    0);
+    std::fill(dyn_counts,  dyn_counts+Dynamic::__LAST,  0);
+    std::fill(dyn_damage,  dyn_damage+Dynamic::__LAST,  0.0f);
+    attacks.clear();   //Capacity is kept for the next replay
+    punishes.clear();
+  }
 };
 
 //Struct for holding all analysis data within a game
@@ -173,25 +191,73 @@ struct Analysis {
   unsigned        timer            = 0;      //Game timer starting minutes
   AnalysisPlayer* ap;                        //Analysis of individual players in the game
   unsigned*       dynamics;                  //Interaction dynamics on a per-frame basis
+  unsigned        dynamics_capacity;         //Number of frames dynamics has room for
+  std::vector<DynamicInterval> dyn_intervals; //Interaction dynamics as runs of frames (covers the same frames as dynamics)
   unsigned        end_type;                  //Game end type
   int             lras_player;               //Player port who LRAS-ed (-1 if none)
 
   Analysis(unsigned frame_count) {
-    dynamics = new unsigned[frame_count]{0}; // List of dynamics active at each frame
-    ap       = new AnalysisPlayer[2];        // The two players being analyzed
+    dynamics          = new unsigned[frame_count](); // List of dynamics active at each frame
+    dynamics_capacity = frame_count;
+    ap                = new AnalysisPlayer[2];       // The two players being analyzed
   }
   ~Analysis() {
     delete [] ap;
     delete [] dynamics;
   }
+  Analysis(const Analysis&) = delete;
+  Analysis& operator=(const Analysis&) = delete;
+
+  //Prepare to analyze another replay of frame_count frames, keeping storage that's already big enough
+  void reset(unsigned frame_count) {
+    success          = false;
+    parse_errors     = 0;
+    game_time.clear();
+    original_file.clear();
+    slippi_version.clear();
+    parser_version.clear();
+    analyzer_version.clear();
+    stage_id         = 0;
+    stage_name.clear();
+    winner_port      = 0;
+    game_length      = 0;
+    timer            = 0;
+    end_type         = 0;
+    lras_player      = -1;
+    if (frame_count > dynamics_capacity) {
+      delete [] dynamics;
+      dynamics          = new unsigned[frame_count];
+      dynamics_capacity = frame_count;
+    }
+    std::fill(dynamics, dynamics+frame_count, 0);
+    dyn_intervals.clear();
+    ap[0].reset();
+    ap[1].reset();
+  }
+
+  //Dynamic in effect on frame f (binary search over dyn_intervals; 0 outside of analyzed frames)
+  inline unsigned dynamicAt(unsigned f) const {
+    auto it = std::upper_bound(dyn_intervals.begin(), dyn_intervals.end(), f,
+      [](unsigned frame, const DynamicInterval& d) { return frame < d.end; });
+    return (it != dyn_intervals.end() && it->start <= f) ? it->dynamic : 0;
+  }
+
+  //Dynamic d as seen by player p (non-neutral dynamics are inverted for the 2nd player)
+  static inline unsigned dynamicFor(unsigned d, unsigned p) {
+    return (p == 1 && (d <= Dynamic::DEFENSIVE || d >= Dynamic::OFFENSIVE)) ? Dynamic::__LAST - d : d;
+  }
 
   std::string asJson();                      //Convert the analysis structure to a JSON
   std::string statsAsJson();
   std::string attacksAsJson();
-  arrow::Status attacksAsParquet();
+  arrow::Status attacksAsParquet(const OutputSink& sink, const ParquetOptions& o = ParquetOptions());
+  arrow::Status attacksAsParquet(ParquetAppender& out);
   std::string punishesAsJson();
-  arrow::Status punishesAsParquet();
-  void save(const char* outfilename);        //Write the analysis out to a JSON file
+  arrow::Status punishesAsParquet(const OutputSink& sink, const ParquetOptions& o = ParquetOptions());
+  arrow::Status punishesAsParquet(ParquetAppender& out);
+  arrow::Status dynamicsAsParquet(const OutputSink& sink, const ParquetOptions& o = ParquetOptions());
+  arrow::Status dynamicsAsParquet(ParquetAppender& out);
+  void save(const OutputSink& sink, const ParquetOptions& o = ParquetOptions(), ParquetBatch* batch = nullptr); //Write the analysis out to JSON and Parquet files in the sink (Parquet to batch, if given)
 };
 
 }
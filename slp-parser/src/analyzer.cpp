@@ -10,10 +10,10 @@ Analyzer::~Analyzer() {
   //Nothing to do yet
 }
 
-bool Analyzer::get1v1Ports(const SlippiReplay &s, Analysis *a) const {
+bool Analyzer::get1v1Ports(const ReplayView &s, Analysis *a) const {
   unsigned num_players = 0;
   for(uint8_t i = 0 ; i < 4; ++i) {
-    if (s.player[i].player_type != 3) {
+    if (s->player[i].player_type != 3) {
       if (num_players == 2) {
         return false;
       }
@@ -27,102 +27,97 @@ bool Analyzer::get1v1Ports(const SlippiReplay &s, Analysis *a) const {
   return true;
 }
 
-void Analyzer::computeAirtime(const SlippiReplay &s, Analysis *a) const {
+void Analyzer::computeAirtime(const ReplayView &s, Analysis *a) const {
     for (unsigned pi = 0; pi < 2; ++pi) {
-      SlippiPlayer p = s.player[a->ap[pi].port];
+      const FrameBits airborne = s.player(a->ap[pi].port).cols.airborne;
       unsigned airframes = 0;
-      for (unsigned f = (-LOAD_FRAME); f < s.frame_count; ++f) {
-        airframes += p.frame[f].airborne;
+      for (unsigned f = (-LOAD_FRAME); f < s->frame_count; ++f) {
+        airframes += airborne[f];
       }
 
       a->ap[pi].air_frames = airframes;
-      // float aircount = 100*((float)airframes / s.last_frame);
+      // float aircount = 100*((float)airframes / s->last_frame);
       // std::cout << "  Airborne for " << aircount  << "% of match" << std::endl;
     }
 }
 
-void Analyzer::getBasicGameInfo(const SlippiReplay &s, Analysis* a) const {
-  a->original_file     = s.original_file;
-  a->slippi_version    = s.slippi_version;
-  a->parser_version    = s.parser_version;
+void Analyzer::getBasicGameInfo(const ReplayView &s, Analysis* a) const {
+  a->original_file     = s->original_file;
+  a->slippi_version    = s->slippi_version;
+  a->parser_version    = s->parser_version;
   a->analyzer_version  = SLIPPC_VERSION;
-  a->parse_errors      = s.errors;
-  a->game_time         = s.start_time;
-  a->game_length       = s.frame_count;
-  a->timer             = s.timer;
-  a->end_type          = s.end_type;
-  a->lras_player       = s.lras;
-  a->ap[0].tag_player  = s.player[a->ap[0].port].tag;
-  a->ap[1].tag_player  = s.player[a->ap[1].port].tag;
-  a->ap[0].tag_css     = s.player[a->ap[0].port].tag_css;
-  a->ap[1].tag_css     = s.player[a->ap[1].port].tag_css;
-  a->ap[0].tag_code    = s.player[a->ap[0].port].tag_code;
-  a->ap[1].tag_code    = s.player[a->ap[1].port].tag_code;
-
-  a->ap[0].start_stocks  = s.player[a->ap[0].port].start_stocks;
-  a->ap[1].start_stocks  = s.player[a->ap[1].port].start_stocks;
-  a->ap[0].color         = s.player[a->ap[0].port].color;
-  a->ap[1].color         = s.player[a->ap[1].port].color;
-  a->ap[0].team_id       = s.player[a->ap[0].port].team_id;
-  a->ap[1].team_id       = s.player[a->ap[1].port].team_id;
-  a->ap[0].player_type   = s.player[a->ap[0].port].player_type;
-  a->ap[1].player_type   = s.player[a->ap[1].port].player_type;
-  a->ap[0].cpu_level     = s.player[a->ap[0].port].cpu_level;
-  a->ap[1].cpu_level     = s.player[a->ap[1].port].cpu_level;
-
-  a->ap[0].end_stocks  = s.player[a->ap[0].port].end_stocks;
-  a->ap[1].end_stocks  = s.player[a->ap[1].port].end_stocks;
-  a->ap[0].end_pct     = s.player[a->ap[0].port].frame[s.frame_count-1].percent_pre;
-  a->ap[1].end_pct     = s.player[a->ap[1].port].frame[s.frame_count-1].percent_pre;
-  a->ap[0].char_id     = s.player[a->ap[0].port].ext_char_id;
-  a->ap[1].char_id     = s.player[a->ap[1].port].ext_char_id;
-  a->stage_id          = s.stage;
+  a->parse_errors      = s->errors;
+  a->game_time         = s->start_time;
+  a->game_length       = s->frame_count;
+  a->timer             = s->timer;
+  a->end_type          = s->end_type;
+  a->lras_player       = s->lras;
+  a->ap[0].tag_player  = s->player[a->ap[0].port].tag;
+  a->ap[1].tag_player  = s->player[a->ap[1].port].tag;
+  a->ap[0].tag_css     = s->player[a->ap[0].port].tag_css;
+  a->ap[1].tag_css     = s->player[a->ap[1].port].tag_css;
+  a->ap[0].tag_code    = s->player[a->ap[0].port].tag_code;
+  a->ap[1].tag_code    = s->player[a->ap[1].port].tag_code;
+
+  a->ap[0].start_stocks  = s->player[a->ap[0].port].start_stocks;
+  a->ap[1].start_stocks  = s->player[a->ap[1].port].start_stocks;
+  a->ap[0].color         = s->player[a->ap[0].port].color;
+  a->ap[1].color         = s->player[a->ap[1].port].color;
+  a->ap[0].team_id       = s->player[a->ap[0].port].team_id;
+  a->ap[1].team_id       = s->player[a->ap[1].port].team_id;
+  a->ap[0].player_type   = s->player[a->ap[0].port].player_type;
+  a->ap[1].player_type   = s->player[a->ap[1].port].player_type;
+  a->ap[0].cpu_level     = s->player[a->ap[0].port].cpu_level;
+  a->ap[1].cpu_level     = s->player[a->ap[1].port].cpu_level;
+
+  a->ap[0].end_stocks  = s->player[a->ap[0].port].end_stocks;
+  a->ap[1].end_stocks  = s->player[a->ap[1].port].end_stocks;
+  a->ap[0].end_pct     = s.player(a->ap[0].port).cols.percent_pre[s->frame_count-1];
+  a->ap[1].end_pct     = s.player(a->ap[1].port).cols.percent_pre[s->frame_count-1];
+  a->ap[0].char_id     = s->player[a->ap[0].port].ext_char_id;
+  a->ap[1].char_id     = s->player[a->ap[1].port].ext_char_id;
+  a->stage_id          = s->stage;
   a->ap[0].char_name   = CharExt::name[a->ap[0].char_id];
   a->ap[1].char_name   = CharExt::name[a->ap[1].char_id];
-  a->stage_name        = Stage::name[s.stage];
-  a->winner_port       = s.winner_id;
+  a->stage_name        = Stage::name[s->stage];
+  a->winner_port       = s->winner_id;
 }
 
-void Analyzer::summarizeInteractions(const SlippiReplay &s, Analysis *a) const {
+void Analyzer::summarizeInteractions(const ReplayView &s, Analysis *a) const {
   // std::cout << "  Summarizing player interactions" << std::endl;
-  for (unsigned f = (PLAYABLE_FRAME-LOAD_FRAME); f < s.frame_count; ++f) {
-    unsigned d = a->dynamics[f];
-    ++(a->ap[0].dyn_counts[d]); //Increase the counter for dynamics across all frames
-    if (d > Dynamic::DEFENSIVE && d < Dynamic::OFFENSIVE) {
-      //Index is the same for the 2nd player for neutral dynamics
-      ++(a->ap[1].dyn_counts[d]);
-    } else {
-      //Index is inverted for the 2nd player for non-neutral dynamics
-      ++(a->ap[1].dyn_counts[Dynamic::__LAST - d]);
-    }
+  for (const DynamicInterval& di : a->dyn_intervals) {
+    unsigned d = di.dynamic;
+    unsigned n = di.end - di.start;
+    a->ap[0].dyn_counts[d] += n; //Increase the counter for dynamics across all frames
+    a->ap[1].dyn_counts[Analysis::dynamicFor(d,1)] += n; //Same for the 2nd player, but from their perspective
   }
   // std::cout << std::fixed; //Show floats in fixed representation
   // for (unsigned p = 0; p < 2; ++p) {
   //   // std::cout << "    From the perspective of port " << int(a->ap[p].port+1) << " (" << a->ap[p].char_name << "):" << std::endl;
   //   for (unsigned i = 0; i < Dynamic::__LAST; ++i) {
   //     std::string n   = std::to_string(a->ap[p].dyn_counts[i]);
-  //     std::string pct = std::to_string((100*float(a->ap[p].dyn_counts[i])/s.frame_count)).substr(0,5);
+  //     std::string pct = std::to_string((100*float(a->ap[p].dyn_counts[i])/s->frame_count)).substr(0,5);
   //     std::cout << "      " << SPACE[6-n.length()] << n << " frames (" << pct
   //       << "% of game) spent in " << Dynamic::name[i] << std::endl;
   //   }
   // }
 }
 
-void Analyzer::countLCancels(const SlippiReplay &s, Analysis *a) const {
+void Analyzer::countLCancels(const ReplayView &s, Analysis *a) const {
   for (unsigned pi = 0; pi < 2; ++pi) {
-    SlippiPlayer p = s.player[a->ap[pi].port];
+    const uint8_t* l_cancel = s.player(a->ap[pi].port).cols.l_cancel;
     unsigned cancels_hit  = 0;
     unsigned cancels_miss = 0;
     unsigned last_state   = 0;
-    for(unsigned f = (-LOAD_FRAME); f < s.frame_count; ++f) {
+    for(unsigned f = (-LOAD_FRAME); f < s->frame_count; ++f) {
       if (last_state == 0) {
-        if (p.frame[f].l_cancel == 1) {
+        if (l_cancel[f] == 1) {
           cancels_hit += 1;
-        } else if (p.frame[f].l_cancel == 2) {
+        } else if (l_cancel[f] == 2) {
           cancels_miss += 1;
         }
       }
-      last_state = p.frame[f].l_cancel;
+      last_state = l_cancel[f];
     }
 
     a->ap[pi].l_cancels_hit    = cancels_hit;
@@ -132,32 +127,32 @@ void Analyzer::countLCancels(const SlippiReplay &s, Analysis *a) const {
   }
 }
 
-void Analyzer::countButtons(const SlippiReplay &s, Analysis *a) const {
+void Analyzer::countButtons(const ReplayView &s, Analysis *a) const {
   for (unsigned pi = 0; pi < 2; ++pi) {
-    SlippiPlayer p        = s.player[a->ap[pi].port];
+    const FrameColumns& c = s.player(a->ap[pi].port).cols;
     uint16_t last_buttons = 0;
     float    last_ax      = 0;
     float    last_ay      = 0;
     float    last_cx      = 0;
     float    last_cy      = 0;
-    for(unsigned f = (-LOAD_FRAME); f < s.frame_count; ++f) {
+    for(unsigned f = (-LOAD_FRAME); f < s->frame_count; ++f) {
       // Add buttons pressed this frame to button count
-      uint16_t cur_buttons    = p.frame[f].buttons;
+      uint16_t cur_buttons    = c.buttons[f];
       uint16_t new_buttons    = cur_buttons&(cur_buttons^last_buttons);
       new_buttons            &= 0x0F70;  //Mask out unused bits
       a->ap[pi].button_count += countBits(new_buttons);
       last_buttons            = cur_buttons;
 
       // Check analog stick for movement
-      float    cur_ax = p.frame[f].joy_x;
-      float    cur_ay = p.frame[f].joy_y;
+      float    cur_ax = c.joy_x[f];
+      float    cur_ay = c.joy_y[f];
       a->ap[pi].astick_count += checkStickMovement(cur_ax,cur_ay,last_ax,last_ay);
       last_ax = cur_ax;
       last_ay = cur_ay;
 
       // Check C stick for movement
-      float    cur_cx = p.frame[f].c_x;
-      float    cur_cy = p.frame[f].c_y;
+      float    cur_cx = c.c_x[f];
+      float    cur_cy = c.c_y[f];
       a->ap[pi].cstick_count += checkStickMovement(cur_cx,cur_cy,last_cx,last_cy);
       last_cx = cur_cx;
       last_cy = cur_cy;
@@ -165,9 +160,9 @@ void Analyzer::countButtons(const SlippiReplay &s, Analysis *a) const {
   }
 }
 
-void Analyzer::countTechs(const SlippiReplay &s, Analysis *a) const {
+void Analyzer::countTechs(const ReplayView &s, Analysis *a) const {
   for (unsigned pi = 0; pi < 2; ++pi) {
-    SlippiPlayer p             = s.player[a->ap[pi].port];
+    const PlayerView p         = s.player(a->ap[pi].port);
     unsigned techs_hit         = 0;
     unsigned walltechs_hit     = 0;  //And ceiling techs
     unsigned walljumps_hit     = 0;
@@ -175,16 +170,16 @@ void Analyzer::countTechs(const SlippiReplay &s, Analysis *a) const {
     unsigned techs_missed      = 0;
     bool     teching           = false;
 
-    for(unsigned f = (-LOAD_FRAME); f < s.frame_count; ++f) {
-      if (inTechState(p.frame[f])) {
+    for(unsigned f = (-LOAD_FRAME); f < s->frame_count; ++f) {
+      if (inTechState(p.frame(f))) {
         if (not teching) {
           teching = true;
-          if (p.frame[f].action_pre <= Action::DownSpotD) {
+          if (p.frame(f).action_pre() <= Action::DownSpotD) {
             ++techs_missed;
-          } else if (p.frame[f].action_pre <= Action::PassiveStandB) {
+          } else if (p.frame(f).action_pre() <= Action::PassiveStandB) {
             ++techs_hit;
-          } else if (p.frame[f].action_pre == Action::PassiveWallJump) {
-            if (inDamagedState(p.frame[f-1]) || inTumble(p.frame[f-1])) {
+          } else if (p.frame(f).action_pre() == Action::PassiveWallJump) {
+            if (inDamagedState(p.frame(f-1)) || inTumble(p.frame(f-1))) {
               ++walljumptechs_hit;
             } else {
               ++walljumps_hit;
@@ -212,11 +207,11 @@ void Analyzer::countTechs(const SlippiReplay &s, Analysis *a) const {
   }
 }
 
-void Analyzer::countDashdances(const SlippiReplay &s, Analysis *a) const {
+void Analyzer::countDashdances(const ReplayView &s, Analysis *a) const {
   for (unsigned pi = 0; pi < 2; ++pi) {
-    SlippiPlayer p = s.player[a->ap[pi].port];
+    const PlayerView p = s.player(a->ap[pi].port);
     unsigned dashdances = 0;
-    for(unsigned f = (-LOAD_FRAME); f < s.frame_count; ++f) {
+    for(unsigned f = (-LOAD_FRAME); f < s->frame_count; ++f) {
       if (isDashdancing(p,f)) {
         ++dashdances;
       }
@@ -228,23 +223,23 @@ void Analyzer::countDashdances(const SlippiReplay &s, Analysis *a) const {
 }
 
 //Code adapted from Fizzi's
-void Analyzer::countAirdodgesAndWavelands(const SlippiReplay &s, Analysis *a) const {
+void Analyzer::countAirdodgesAndWavelands(const ReplayView &s, Analysis *a) const {
   for (unsigned pi = 0; pi < 2; ++pi) {
-    SlippiPlayer p = s.player[a->ap[pi].port];
+    const PlayerView p = s.player(a->ap[pi].port);
     int airdodges  = 0;
     unsigned wavelands  = 0;
     unsigned wavedashes = 0;
     bool     airdodging = false;
-    for(unsigned f = (-LOAD_FRAME); f < s.frame_count; ++f) {
+    for(unsigned f = (-LOAD_FRAME); f < s->frame_count; ++f) {
       if (maybeWavelanding(p,f)) {  //Waveland detection by Fizzi
         //Look at the last 8 frames (including this one) re Fizzi
         bool foundAirdodge  = false;
         bool foundJumpsquat = false;
         bool foundOther     = false;
         for(unsigned i = 1; i < 8; ++i) {
-          if (isAirdodging(p.frame[f-i])) {
+          if (isAirdodging(p.frame(f-i))) {
             foundAirdodge = true;
-          } else if (isInJumpsquat(p.frame[f-i])) {
+          } else if (isInJumpsquat(p.frame(f-i))) {
             foundJumpsquat = true;
             break;
           } else {
@@ -263,7 +258,7 @@ void Analyzer::countAirdodgesAndWavelands(const SlippiReplay &s, Analysis *a) co
         } else if (foundOther) {  //If we were in any other animation besides airdodge, it's a waveland
           ++wavelands;
         }  //Otherwise, nothing special happened
-      } else if (isAirdodging(p.frame[f])) {
+      } else if (isAirdodging(p.frame(f))) {
         if (not airdodging) {
           ++airdodges;
           airdodging = true;
@@ -283,10 +278,10 @@ void Analyzer::countAirdodgesAndWavelands(const SlippiReplay &s, Analysis *a) co
   }
 }
 
-void Analyzer::analyzeInteractions(const SlippiReplay &s, Analysis *a) const {
+void Analyzer::analyzeInteractions(const ReplayView &s, Analysis *a) const {
   // std::cout << "  Analyzing player interactions" << std::endl;
-  const SlippiPlayer *p                = &(s.player[a->ap[0].port]);
-  const SlippiPlayer *o                = &(s.player[a->ap[1].port]);
+  const PlayerView p                   = s.player(a->ap[0].port);
+  const PlayerView o                   = s.player(a->ap[1].port);
 
   unsigned cur_dynamic                 = Dynamic::POSITIONING; // Current dynamic in effect
 
@@ -300,16 +295,16 @@ void Analyzer::analyzeInteractions(const SlippiReplay &s, Analysis *a) const {
   bool     pHitLastFrame               = false;
 
   //All interactions analyzed from perspective of p (lower port player)
-  for (unsigned f = (PLAYABLE_FRAME-LOAD_FRAME); f < s.frame_count; ++f) {
+  for (unsigned f = (PLAYABLE_FRAME-LOAD_FRAME); f < s->frame_count; ++f) {
     //Important variables for each frame
-    SlippiFrame of     = o->frame[f];
-    SlippiFrame pf     = p->frame[f];
+    FrameView of     = o.frame(f);
+    FrameView pf     = p.frame(f);
     oHitLastFrame = oHitThisFrame;
     oHitThisFrame = false;
     bool oInHitstun    = isInHitstun(of);
       if (oInHitstun)    {
         oLastInHitsun = f;
-        if (of.percent_post > o->frame[f-1].percent_post) {
+        if (of.percent_post() > o.frame(f-1).percent_post()) {
           oHitThisFrame = true; //Check if opponent was hit this frame by looking at % last frame
         }
       }
@@ -318,7 +313,7 @@ void Analyzer::analyzeInteractions(const SlippiReplay &s, Analysis *a) const {
     bool pInHitstun    = isInHitstun(pf);
       if (pInHitstun)    {
         pLastInHitsun = f;
-        if (pf.percent_post > p->frame[f-1].percent_post) {
+        if (pf.percent_post() > p.frame(f-1).percent_post()) {
           pHitThisFrame = true; //Check if we were hit this frame by looking at % last frame
         }
       }
@@ -489,35 +484,46 @@ void Analyzer::analyzeInteractions(const SlippiReplay &s, Analysis *a) const {
 
     //Aggregate results
     a->dynamics[f] = cur_dynamic;  //Set the dynamic for this frame to the current dynamic computed
-    DOUT3("    " << f << " (" << frameAsTimer(f,s.timer) << ") P1 "
+    if (a->dyn_intervals.empty() || a->dyn_intervals.back().dynamic != cur_dynamic) {
+      a->dyn_intervals.push_back({f, f+1, cur_dynamic});  //Dynamic changed, so start a new run
+    } else {
+      a->dyn_intervals.back().end = f+1;
+    }
+    DOUT3("    " << f << " (" << frameAsTimer(f,s->timer) << ") P1 "
       << Dynamic::name[cur_dynamic]);
   }
 
 }
 
-void Analyzer::analyzePunishes(const SlippiReplay &s, Analysis *a) const {
-  const SlippiPlayer *p  = &(s.player[a->ap[0].port]);
-  const SlippiPlayer *o  = &(s.player[a->ap[1].port]);
+void Analyzer::analyzePunishes(const ReplayView &s, Analysis *a) const {
+  const PlayerView p     = s.player(a->ap[0].port);
+  const PlayerView o     = s.player(a->ap[1].port);
   unsigned pa            = 0; //Running tally of player attacks
   unsigned oa            = 0; //Running tally of opponent attacks
   unsigned pn            = 0; //Running tally of player punishes
   unsigned on            = 0; //Running tally of opponent punishes
   unsigned oLastInHitsun = 0;
   unsigned pLastInHitsun = 0;
-  unsigned cur_dyn       = a->dynamics[FIRST_FRAME];
-  unsigned last_dyn      = a->dynamics[FIRST_FRAME];
-  Punish *pPunishes      = a->ap[0].punishes;
-  Punish *oPunishes      = a->ap[1].punishes;
-  Attack *pAttacks       = a->ap[0].attacks;
-  Attack *oAttacks       = a->ap[1].attacks;
-
-  for (unsigned f = FIRST_FRAME; f < s.frame_count; ++f) {
-    SlippiFrame pf = p->frame[f];
-    SlippiFrame of = o->frame[f];
-    cur_dyn        = a->dynamics[f];
-
-    oLastInHitsun = isInHitstun(o->frame[f]) ? f : oLastInHitsun;
-    pLastInHitsun = isInHitstun(p->frame[f]) ? f : pLastInHitsun;
+  unsigned di            = 0; //Index of the dynamic interval containing the current frame
+  unsigned cur_dyn       = a->dynamicAt(FIRST_FRAME);
+  unsigned last_dyn      = cur_dyn;
+  std::vector<Punish> &pPunishes = a->ap[0].punishes;
+  std::vector<Punish> &oPunishes = a->ap[1].punishes;
+  std::vector<Attack> &pAttacks  = a->ap[0].attacks;
+  std::vector<Attack> &oAttacks  = a->ap[1].attacks;
+  pPunishes.emplace_back();  //The last punish is always the one in progress (possibly not started yet)
+  oPunishes.emplace_back();
+
+  for (unsigned f = FIRST_FRAME; f < s->frame_count; ++f) {
+    FrameView pf = p.frame(f);
+    FrameView of = o.frame(f);
+    while (a->dyn_intervals[di].end <= f) {
+      ++di;
+    }
+    cur_dyn        = a->dyn_intervals[di].dynamic;
+
+    oLastInHitsun = isInHitstun(o.frame(f)) ? f : oLastInHitsun;
+    pLastInHitsun = isInHitstun(p.frame(f)) ? f : pLastInHitsun;
     bool oPoked    = ((f - oLastInHitsun) < POKE_THRES);  //Check if opponent has been poked recently
     bool pPoked    = ((f - pLastInHitsun) < POKE_THRES);  //Check if we have been poked recently
 
@@ -529,8 +535,8 @@ void Analyzer::analyzePunishes(const SlippiReplay &s, Analysis *a) const {
     }
 
     //Check if either player lost a stock
-    if (pf.stocks < p->frame[f-1].stocks) {
-      unsigned ddir = deathDirection(*p,f);
+    if (pf.stocks() < p.frame(f-1).stocks()) {
+      unsigned ddir = deathDirection(p,f);
       if (oa > 0) {
         oAttacks[oa-1].kill_dir = ddir;
       }
@@ -545,8 +551,8 @@ void Analyzer::analyzePunishes(const SlippiReplay &s, Analysis *a) const {
         ++(a->ap[0].self_destructs);
       }
     }
-    if (of.stocks < o->frame[f-1].stocks) {
-      unsigned ddir = deathDirection(*o,f);
+    if (of.stocks() < o.frame(f-1).stocks()) {
+      unsigned ddir = deathDirection(o,f);
       if (pa > 0) {
         pAttacks[pa-1].kill_dir = ddir;
       }
@@ -565,7 +571,7 @@ void Analyzer::analyzePunishes(const SlippiReplay &s, Analysis *a) const {
     //Check if either player has dropped a punish off an opening
     bool pPunishEnd = false;
     bool oPunishEnd = false;
-    if (f == s.frame_count-1) {
+    if (f == s->frame_count-1) {
       pPunishEnd = true;
       oPunishEnd = true;
     } else if (cur_dyn != Dynamic::POKING) {
@@ -583,37 +589,40 @@ void Analyzer::analyzePunishes(const SlippiReplay &s, Analysis *a) const {
     if (pPunishEnd && pa > 0) {
       if (pPunishes[pn].num_moves > 0) {
         pPunishes[pn].end_frame    = f;
-        pPunishes[pn].end_pct      = of.percent_pre;
-        pPunishes[pn].last_move_id = pf.hit_with;
+        pPunishes[pn].end_pct      = of.percent_pre();
+        pPunishes[pn].last_move_id = pf.hit_with();
         if(pPunishes[pn].num_moves > pAttacks[pa-1].hit_id) {
           a->ap[0].neutral_wins += 1;
         } else {
           a->ap[0].pokes += 1;
         }
         ++pn;
+        pPunishes.emplace_back();
       }
     }
     if (oPunishEnd && oa > 0) {
       if (oPunishes[on].num_moves > 0) {
         oPunishes[on].end_frame    = f;
-        oPunishes[on].end_pct      = pf.percent_pre;
-        oPunishes[on].last_move_id = of.hit_with;
+        oPunishes[on].end_pct      = pf.percent_pre();
+        oPunishes[on].last_move_id = of.hit_with();
         if(oPunishes[on].num_moves > oAttacks[oa-1].hit_id) {
           a->ap[1].neutral_wins += 1;
         } else {
           a->ap[1].pokes += 1;
         }
         ++on;
+        oPunishes.emplace_back();
       }
     }
 
     //If the opponent just took damage
-    float o_damage_taken = of.percent_pre - o->frame[f-1].percent_pre;
+    float o_damage_taken = of.percent_pre() - o.frame(f-1).percent_pre();
     if (o_damage_taken > 0) {
+      pAttacks.emplace_back();
       //Check for bubble damage
-      pAttacks[pa].move_id    = (isOffscreen(of) && o_damage_taken == 1) ? Move::BUBBLE : pf.hit_with;
+      pAttacks[pa].move_id    = (isOffscreen(of) && o_damage_taken == 1) ? Move::BUBBLE : pf.hit_with();
       //Last frame we actually took damage; frame before that gives us the animation frame our move hit
-      pAttacks[pa].anim_frame = p->frame[f-2].action_fc;
+      pAttacks[pa].anim_frame = p.frame(f-2).action_fc();
       pAttacks[pa].punish_id  = pn;
       if (  //Check if this is a consecutive hit from a multihit move
        pa > 0 &&  //If this isn't our first move
@@ -636,24 +645,25 @@ void Analyzer::analyzePunishes(const SlippiReplay &s, Analysis *a) const {
       //If this is the start of a combo
       if (pPunishes[pn].num_moves == 0) {
         pPunishes[pn].start_frame = f;
-        pPunishes[pn].start_pct   = o->frame[f-1].percent_pre;
-        pPunishes[pn].stocks      = o->frame[f-1].stocks;
+        pPunishes[pn].start_pct   = o.frame(f-1).percent_pre();
+        pPunishes[pn].stocks      = o.frame(f-1).stocks();
         pPunishes[pn].kill_dir    = Dir::NEUT;
       }
       a->ap[0].damage_dealt      += o_damage_taken;
       pPunishes[pn].end_frame     = f;
-      pPunishes[pn].end_pct       = of.percent_pre;
-      pPunishes[pn].last_move_id  = pf.hit_with;
+      pPunishes[pn].end_pct       = of.percent_pre();
+      pPunishes[pn].last_move_id  = pf.hit_with();
       pPunishes[pn].num_moves    += 1;
     }
 
     //If we just took damage
-    float p_damage_taken = pf.percent_pre - p->frame[f-1].percent_pre;
+    float p_damage_taken = pf.percent_pre() - p.frame(f-1).percent_pre();
     if (p_damage_taken > 0) {
+      oAttacks.emplace_back();
       //Check for bubble damage
-      oAttacks[oa].move_id    = (isOffscreen(pf) && p_damage_taken == 1)  ? Move::BUBBLE : of.hit_with;
+      oAttacks[oa].move_id    = (isOffscreen(pf) && p_damage_taken == 1)  ? Move::BUBBLE : of.hit_with();
       //Last frame we actually took damage; frame before that gives us the animation frame our move hit
-      oAttacks[oa].anim_frame = o->frame[f-2].action_fc;
+      oAttacks[oa].anim_frame = o.frame(f-2).action_fc();
       oAttacks[oa].punish_id  = on;
       if (  //Check if this is a consecutive hit from a multihit move
        oa > 0 &&  //If this isn't our first move
@@ -677,51 +687,59 @@ void Analyzer::analyzePunishes(const SlippiReplay &s, Analysis *a) const {
       //If this is the start of a combo
       if (oPunishes[on].num_moves == 0) {
         oPunishes[on].start_frame = f;
-        oPunishes[on].start_pct   = p->frame[f-1].percent_pre;
-        oPunishes[on].stocks      = p->frame[f-1].stocks;
+        oPunishes[on].start_pct   = p.frame(f-1).percent_pre();
+        oPunishes[on].stocks      = p.frame(f-1).stocks();
         oPunishes[on].kill_dir    = Dir::NEUT;
       }
       a->ap[1].damage_dealt      += p_damage_taken;
       oPunishes[on].end_frame     = f;
-      oPunishes[on].end_pct       = pf.percent_pre;
-      oPunishes[on].last_move_id  = of.hit_with;
+      oPunishes[on].end_pct       = pf.percent_pre();
+      oPunishes[on].last_move_id  = of.hit_with();
       oPunishes[on].num_moves    += 1;
     }
 
     last_dyn = cur_dyn;  //Update the last dynamic
   }
+
+  //Drop the punishes that never started
+  if (pPunishes.back().num_moves == 0) {
+    pPunishes.pop_back();
+  }
+  if (oPunishes.back().num_moves == 0) {
+    oPunishes.pop_back();
+  }
 }
 
-void Analyzer::analyzeCancels(const SlippiReplay &s, Analysis *a) const {
+void Analyzer::analyzeCancels(const ReplayView &s, Analysis *a) const {
   for(unsigned pi = 0; pi < 2; ++pi) {
-    const SlippiPlayer *p = &(s.player[a->ap[pi].port]);
-    Attack *attacks       = a->ap[pi].attacks;
-    for(unsigned i = 0; attacks[i].frame > 0; ++i) {
+    const PlayerView p    = s.player(a->ap[pi].port);
+    std::vector<Attack> &attacks = a->ap[pi].attacks;
+    for(unsigned i = 0; i < attacks.size(); ++i) {
       unsigned f             = attacks[i].frame;
       if (attacks[i].move_id >= Move::NAIR && attacks[i].move_id <= Move::DAIR) {
         unsigned last_frame = attacks[i].frame+60;
-        if (last_frame > s.frame_count) {
-          last_frame = s.frame_count;
+        if (last_frame > s->frame_count) {
+          last_frame = s->frame_count;
         }
         for(unsigned f = attacks[i].frame; f < last_frame; ++f) {
           //Check if we had the opportunity to edge cancel
-          if (didEdgeCancelAerial(p->frame[f])) {
+          if (didEdgeCancelAerial(p.frame(f))) {
             attacks[i].cancel_type = Cancel::EDGE;
             break;
           }
           //Check if we had the opportunity to teeter cancel
-          if (didTeeterCancelAerial(p->frame[f])) {
+          if (didTeeterCancelAerial(p.frame(f))) {
             attacks[i].cancel_type = Cancel::TEETER;
             break;
           }
           //Check if we had the opportunity to autocancel
-          if (didAutoCancelAerial(p->frame[f])) {
+          if (didAutoCancelAerial(p.frame(f))) {
             attacks[i].cancel_type = Cancel::AUTO;
             break;
           }
           //Check if we had the opportunity to L cancel
-          if (p->frame[f].l_cancel > 0) {
-            if (p->frame[f].l_cancel == 1) {
+          if (p.frame(f).l_cancel() > 0) {
+            if (p.frame(f).l_cancel() == 1) {
               attacks[i].cancel_type = Cancel::L;
             }
             break;
@@ -732,28 +750,28 @@ void Analyzer::analyzeCancels(const SlippiReplay &s, Analysis *a) const {
   }
 }
 
-void Analyzer::analyzeShield(const SlippiReplay &s, Analysis *a) const {
+void Analyzer::analyzeShield(const ReplayView &s, Analysis *a) const {
   for(unsigned pi = 0; pi < 2; ++pi) {
-    const SlippiPlayer *p = &(s.player[a->ap[pi].port]);
-    for(unsigned f = (-LOAD_FRAME); f < s.frame_count; ++f) {
-      float shield_damage = (p->frame[f].shield - p->frame[f-1].shield);
+    const PlayerView p    = s.player(a->ap[pi].port);
+    for(unsigned f = (-LOAD_FRAME); f < s->frame_count; ++f) {
+      float shield_damage = (p.frame(f).shield() - p.frame(f-1).shield());
       if (shield_damage > 0) {
         a->ap[pi].shield_time   += 1;
         a->ap[pi].shield_damage += shield_damage;
-        if(p->frame[f].shield < a->ap[pi].shield_lowest) {
-          a->ap[pi].shield_lowest = p->frame[f].shield;
+        if(p.frame(f).shield() < a->ap[pi].shield_lowest) {
+          a->ap[pi].shield_lowest = p.frame(f).shield();
         }
       }
     }
   }
 }
 
-unsigned Analyzer::countTransitions(const SlippiReplay &s, Analysis *a, unsigned pnum, bool (*cb)(const SlippiFrame&)) const {
-  SlippiPlayer p = s.player[a->ap[pnum].port];
+unsigned Analyzer::countTransitions(const ReplayView &s, Analysis *a, unsigned pnum, bool (*cb)(const FrameView&)) const {
+  const PlayerView p = s.player(a->ap[pnum].port);
   unsigned counter = 0;
   bool active = false;
-  for(unsigned f = (-LOAD_FRAME); f < s.frame_count; ++f) {
-    if (cb(p.frame[f])) {
+  for(unsigned f = (-LOAD_FRAME); f < s->frame_count; ++f) {
+    if (cb(p.frame(f))) {
       if(not active) {
         ++counter;
         active = true;
@@ -765,11 +783,11 @@ unsigned Analyzer::countTransitions(const SlippiReplay &s, Analysis *a, unsigned
   return counter;
 }
 
-unsigned Analyzer::countTransitions(const SlippiReplay &s, Analysis *a, unsigned pnum, bool (*cb)(const SlippiPlayer &, const unsigned)) const {
-  SlippiPlayer p = s.player[a->ap[pnum].port];
+unsigned Analyzer::countTransitions(const ReplayView &s, Analysis *a, unsigned pnum, bool (*cb)(const PlayerView &, const unsigned)) const {
+  const PlayerView p = s.player(a->ap[pnum].port);
   unsigned counter = 0;
   bool active = false;
-  for(unsigned f = (-LOAD_FRAME); f < s.frame_count; ++f) {
+  for(unsigned f = (-LOAD_FRAME); f < s->frame_count; ++f) {
     if (cb(p,f)) {
       if(not active) {
         ++counter;
@@ -782,7 +800,7 @@ unsigned Analyzer::countTransitions(const SlippiReplay &s, Analysis *a, unsigned
   return counter;
 }
 
-void Analyzer::countBasicAnimations(const SlippiReplay &s, Analysis *a) const {
+void Analyzer::countBasicAnimations(const ReplayView &s, Analysis *a) const {
   for (unsigned pi = 0; pi < 2; ++pi) {
     a->ap[pi].state_changes          = countTransitions(s,a,pi,didActionStateChange);
 
@@ -811,50 +829,50 @@ void Analyzer::countBasicAnimations(const SlippiReplay &s, Analysis *a) const {
   }
 }
 
-void Analyzer::showActionStates(const SlippiReplay &s, Analysis *a) const {
-  const SlippiPlayer *p         = &(s.player[a->ap[0].port]);
-  const SlippiPlayer *o         = &(s.player[a->ap[1].port]);
-  for (unsigned f = FIRST_FRAME; f < s.frame_count; ++f) {
-    SlippiFrame pf = p->frame[f];
-    DOUT2("    " << f << " (" << frameAsTimer(f,s.timer) << ") P1 "
-      << Action::name[pf.action_pre] << " "
+void Analyzer::showActionStates(const ReplayView &s, Analysis *a) const {
+  const PlayerView p            = s.player(a->ap[0].port);
+  const PlayerView o            = s.player(a->ap[1].port);
+  for (unsigned f = FIRST_FRAME; f < s->frame_count; ++f) {
+    FrameView pf = p.frame(f);
+    DOUT2("    " << f << " (" << frameAsTimer(f,s->timer) << ") P1 "
+      << Action::name[pf.action_pre()] << " "
       << " -> "
-      << " " << Action::name[pf.action_post]);
-    SlippiFrame of = o->frame[f];
-    DOUT2("    " << f << " (" << frameAsTimer(f,s.timer) << ") P2 "
-      << Action::name[of.action_pre] << " "
+      << " " << Action::name[pf.action_post()]);
+    FrameView of = o.frame(f);
+    DOUT2("    " << f << " (" << frameAsTimer(f,s->timer) << ") P2 "
+      << Action::name[of.action_pre()] << " "
       << " -> "
-      << " " << Action::name[of.action_post]);
+      << " " << Action::name[of.action_post()]);
   }
 }
 
-void Analyzer::countPhantoms(const SlippiReplay &s, Analysis *a) const {
-  const SlippiPlayer *p         = &(s.player[a->ap[0].port]);
-  const SlippiPlayer *o         = &(s.player[a->ap[1].port]);
-  for (unsigned f = FIRST_FRAME; f < s.frame_count; ++f) {
-    if (wasHitByPhantom(*p,*o,f)) {
+void Analyzer::countPhantoms(const ReplayView &s, Analysis *a) const {
+  const PlayerView p            = s.player(a->ap[0].port);
+  const PlayerView o            = s.player(a->ap[1].port);
+  for (unsigned f = FIRST_FRAME; f < s->frame_count; ++f) {
+    if (wasHitByPhantom(p,o,f)) {
       ++(a->ap[1].phantom_hits);
     }
-    if (wasHitByPhantom(*o,*p,f)) {
+    if (wasHitByPhantom(o,p,f)) {
       ++(a->ap[0].phantom_hits);
     }
   }
 }
 
-void Analyzer::countLedgedashes(const SlippiReplay &s, Analysis *a) const {
+void Analyzer::countLedgedashes(const ReplayView &s, Analysis *a) const {
   for (unsigned pi = 0; pi < 2; ++pi) {
-    const SlippiPlayer *p  = &(s.player[a->ap[pi].port]);
+    const PlayerView p     = s.player(a->ap[pi].port);
     unsigned galint        = 0;
     bool     offledge      = false;
-    for (unsigned f = FIRST_FRAME; f < s.frame_count; ++f) {
+    for (unsigned f = FIRST_FRAME; f < s->frame_count; ++f) {
       if (galint > 0) {
         --galint;
         if (not offledge) {
-          offledge = didReleaseLedge(*p,f);
+          offledge = didReleaseLedge(p,f);
           continue;
         }
-        SlippiFrame pf = p->frame[f];
-        bool landed    = isLanding(p->frame[f-1]) && (not isLanding(pf)) && (not isAirborne(pf));
+        FrameView pf = p.frame(f);
+        bool landed    = isLanding(p.frame(f-1)) && (not isLanding(pf)) && (not isAirborne(pf));
         if ((didNoImpactLand(pf) || landed) && (not isInHitlag(pf)) && (not isInHitstun(pf))) {
           if (a->ap[pi].max_galint < galint) {
             a->ap[pi].max_galint        = galint;
@@ -866,9 +884,9 @@ void Analyzer::countLedgedashes(const SlippiReplay &s, Analysis *a) const {
           offledge                      = false;
         }
       }
-      if(didCliffCatchEnd(*p,f)) {
+      if(didCliffCatchEnd(p,f)) {
         galint        = 30;
-        if (didReleaseLedge(*p,f)) {
+        if (didReleaseLedge(p,f)) {
           offledge = true;
         }
       }
@@ -879,18 +897,18 @@ void Analyzer::countLedgedashes(const SlippiReplay &s, Analysis *a) const {
   }
 }
 
-void Analyzer::countMoves(const SlippiReplay &s, Analysis *a) const {
+void Analyzer::countMoves(const ReplayView &s, Analysis *a) const {
   for (unsigned pi = 0; pi < 2; ++pi) {
-    const SlippiPlayer *p  = &(s.player[a->ap[pi].port]);
-    const unsigned pid = p->ext_char_id;
+    const PlayerView p     = s.player(a->ap[pi].port);
+    const unsigned pid = p.info.ext_char_id;
     bool was_throw   = false;
     bool was_normal  = false;
     bool was_special = false;
     bool was_misc    = false;
     bool was_grab    = false;
     bool was_pummel  = false;
-    for (unsigned f = FIRST_FRAME; f < s.frame_count; ++f) {
-      SlippiFrame pf = p->frame[f];
+    for (unsigned f = FIRST_FRAME; f < s->frame_count; ++f) {
+      FrameView pf = p.frame(f);
       if (isThrowing(pf)) {
         if (!(was_throw)) {
           ++(a->ap[pi].used_throws);
@@ -943,9 +961,9 @@ void Analyzer::countMoves(const SlippiReplay &s, Analysis *a) const {
   }
 }
 
-void Analyzer::countActionability(const SlippiReplay &s, Analysis *a) const {
+void Analyzer::countActionability(const ReplayView &s, Analysis *a) const {
   for (unsigned pi = 0; pi < 2; ++pi) {
-    const SlippiPlayer *p  = &(s.player[a->ap[pi].port]);
+    const PlayerView p     = s.player(a->ap[pi].port);
     bool     was_in_hitstun     = false;
     unsigned hitstun_times      = 0; //Number of times we enter hitstun
     unsigned hitstun_act        = 0; //Total number of frames we take to act out of hitstun
@@ -958,8 +976,8 @@ void Analyzer::countActionability(const SlippiReplay &s, Analysis *a) const {
     unsigned wait_times         = 0; //Number of times we enter wait
     unsigned wait_act           = 0; //Total number of frames we take to act out of wait
     unsigned wait_act_cur       = 0; //Current number of frames we take to act out of wait
-    for (unsigned f = FIRST_FRAME; f < s.frame_count; ++f) {
-      SlippiFrame pf = p->frame[f];
+    for (unsigned f = FIRST_FRAME; f < s->frame_count; ++f) {
+      FrameView pf = p.frame(f);
 
       // Count the number of frames we take to act out of hitstun
       if (isInHitstun(pf)) {
@@ -1042,7 +1060,7 @@ void Analyzer::countActionability(const SlippiReplay &s, Analysis *a) const {
   }
 }
 
-void Analyzer::computeTrivialInfo(const SlippiReplay &s, Analysis *a) const {
+void Analyzer::computeTrivialInfo(const ReplayView &s, Analysis *a) const {
   for (unsigned pi = 0; pi < 2; ++pi) {
     // Get damage per opening
     a->ap[pi].total_openings       = a->ap[pi].neutral_wins + a->ap[pi].pokes;
@@ -1114,16 +1132,22 @@ void Analyzer::computeTrivialInfo(const SlippiReplay &s, Analysis *a) const {
   }
 }
 
-Analysis* Analyzer::analyze(const SlippiReplay &s) {
+Analysis* Analyzer::analyze(const ReplayView &s) {
+  Analysis *a = new Analysis(s->frame_count);  //Structure for holding the analysis so far
+  analyze(s,a);
+  return a;
+}
+
+bool Analyzer::analyze(const ReplayView &s, Analysis *a) {
   DOUT1("  Analyzing replay");
 
-  Analysis *a = new Analysis(s.frame_count);  //Structure for holding the analysis so far
+  a->reset(s->frame_count);
 
   //Verify this is a 1 v 1 match; can't analyze otherwise
   if (not get1v1Ports(s,a)) {
     FAIL("    Not a two player match; refusing to analyze further");
     a->success = false;
-    return a;
+    return false;
   }
 
   DOUT1("    Analyzing basic game info");
@@ -1176,7 +1200,7 @@ Analysis* Analyzer::analyze(const SlippiReplay &s) {
 
   a->success = true;
   DOUT1("  Successfully analyzed replay!");
-  return a;
+  return true;
 }
 
 }
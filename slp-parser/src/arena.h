@@ -0,0 +1,107 @@
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// Bump allocator for per-replay frame storage: nothing is freed individually,
+//   and reset() recycles everything at once, so a Parser that loads many replays
+//   stops touching the heap once it has seen its largest one
+
+namespace slip {
+
+const size_t ARENA_MIN_CHUNK = 1 << 20; //Smallest chunk requested from the heap (1 MiB)
+const size_t ARENA_ALIGN     = 64;      //Alignment of every allocation (one cache line)
+
+class Arena {
+private:
+  struct Chunk {
+    char*  base;  //Start of the chunk
+    size_t size;  //Size of the chunk in bytes
+  };
+  std::vector<Chunk> _chunks;          //Chunks requested from the heap; allocations come from the last one
+  size_t             _used        = 0; //Bytes handed out from the last chunk
+  size_t             _total       = 0; //Bytes handed out since the last reset
+  size_t             _peak        = 0; //Most bytes handed out between two resets
+  unsigned           _heap_allocs = 0; //Number of chunks ever requested from the heap
+
+  inline static size_t _round(size_t bytes) {
+    return (bytes+ARENA_ALIGN-1) & ~(ARENA_ALIGN-1);
+  }
+
+  inline void _addChunk(size_t bytes) {
+    size_t size = std::max({bytes, ARENA_MIN_CHUNK, _chunks.empty() ? 0 : 2*_chunks.back().size});
+    _chunks.push_back({static_cast<char*>(::operator new(size, std::align_val_t(ARENA_ALIGN))), size});
+    _used = 0;
+    ++_heap_allocs;
+  }
+
+  inline void _freeChunks() {
+    for (const Chunk& c : _chunks) {
+      ::operator delete(c.base, std::align_val_t(ARENA_ALIGN));
+    }
+    _chunks.clear();
+  }
+
+public:
+  Arena() = default;
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+  ~Arena() {
+    _freeChunks();
+  }
+
+  //Hand out a zeroed, cache-line-aligned block of at least the given size
+  inline void* allocate(size_t bytes) {
+    bytes = _round(std::max(bytes,size_t(1)));
+    if (_chunks.empty() || _used+bytes > _chunks.back().size) {
+      _addChunk(bytes);
+    }
+    char* p = _chunks.back().base+_used;
+    _used  += bytes;
+    _total += bytes;
+    memset(p, 0, bytes);
+    return p;
+  }
+
+  //Allocate and default-construct n objects (never destroyed, so they must not need destructors)
+  template <typename T>
+  inline T* make(size_t n) {
+    static_assert(std::is_trivially_destructible<T>::value, "Arena objects are never destroyed");
+    static_assert(alignof(T) <= ARENA_ALIGN, "Arena can't align this type");
+    T* p = static_cast<T*>(allocate(n*sizeof(T)));
+    for (size_t i = 0; i < n; ++i) {
+      new (p+i) T();
+    }
+    return p;
+  }
+
+  //Recycle every allocation; if the last replay needed several chunks, replace them
+  //  with a single chunk big enough for the largest replay seen so far
+  inline void reset() {
+    _peak = std::max(_peak,_total);
+    if (_chunks.size() > 1) {
+      _freeChunks();
+      _addChunk(_round(_peak));
+    }
+    _used  = 0;
+    _total = 0;
+  }
+
+  inline size_t   capacity() const {  //Bytes currently held from the heap
+    size_t bytes = 0;
+    for (const Chunk& c : _chunks) {
+      bytes += c.size;
+    }
+    return bytes;
+  }
+  inline size_t   used()           const { return _total; }       //Bytes handed out since the last reset
+  inline unsigned heapAllocations() const { return _heap_allocs; } //Chunks ever requested from the heap
+};
+
+}
+
+#endif /* ARENA_H_ */
@@ -0,0 +1,194 @@
+#include <chrono>
+#include <filesystem>
+#include <vector>
+
+#include <parquet/arrow/reader.h>
+
+#include "util.h"
+#include "parser.h"
+
+// Parser throughput benchmark: repeatedly loads each replay given on the
+//   command line and reports events, frames, and bytes parsed per second.
+//   With -w, also writes its player frames with each Parquet preset and reports
+//   write time, file size, and the time to scan a few columns back.
+
+static int _debug = 0;
+
+namespace slip {
+
+// https://stackoverflow.com/questions/865668/how-to-parse-command-line-arguments-in-c
+char* getCmdOption(char ** begin, char ** end, const std::string & option) {
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end) {
+    return *itr;
+  }
+  return 0;
+}
+
+bool cmdOptionExists(char** begin, char** end, const std::string& option) {
+  return std::find(begin, end, option) != end;
+}
+
+void printUsage() {
+  std::cout
+    << "Usage: slippc-bench [-n <iterations>] [-p <threads>] [-s] [-w] [-d <debuglevel>] <replay.slp> [<replay.slp> ...]:" << std::endl
+    << "  -n        Number of times to parse each replay (default 20)" << std::endl
+    << "  -p        Decode frames with <threads> threads (0 = one per core; default 1)" << std::endl
+    << "  -s        Parse in summary mode (settings and metadata only)" << std::endl
+    << "  -w        Compare Parquet presets on each replay's player frames" << std::endl
+    << "  -d        Run at debug level <debuglevel>" << std::endl
+    << "  -h        Show this help message" << std::endl
+    ;
+}
+
+//Count the events in a replay's raw block by walking the payload sizes
+uint32_t countEvents(const char* path) {
+  std::ifstream in(path, std::ios::binary);
+  std::vector<char> b((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  if (b.size() < MIN_REPLAY_LENGTH) {
+    return 0;
+  }
+  uint16_t sizes[256] = {0};
+  uint32_t raw_end    = N_HEADER_BYTES+readBE4U(&b[11]);
+  if (raw_end == N_HEADER_BYTES || raw_end > b.size()) {
+    raw_end = b.size();
+  }
+  uint32_t ev_bytes = uint8_t(b[N_HEADER_BYTES+1]);
+  for(uint32_t i = N_HEADER_BYTES+2; i+2 < N_HEADER_BYTES+1+ev_bytes; i += 3) {
+    sizes[uint8_t(b[i])] = readBE2U(&b[i+1])+1;
+  }
+  uint32_t events = 1;  //Event payloads event
+  for(uint32_t bp = N_HEADER_BYTES+1+ev_bytes; bp < raw_end; ++events) {
+    unsigned shift = sizes[uint8_t(b[bp])];
+    if (shift == 0) {
+      break;
+    }
+    bp += shift;
+  }
+  return events;
+}
+
+//Read back the columns a typical query touches, as an Athena-style scan would
+bool scanFrames(const std::string& path) {
+  auto file = arrow::io::ReadableFile::Open(path);
+  if (!file.ok()) {
+    return false;
+  }
+  auto reader = parquet::arrow::OpenFile(file.ValueOrDie(), arrow::default_memory_pool());
+  if (!reader.ok()) {
+    return false;
+  }
+  std::shared_ptr<arrow::Table> table;
+  return reader.ValueOrDie()->ReadTable({3,13,14,30}, &table).ok();  //frame_number, pos_x_post, pos_y_post, action_post
+}
+
+//Write a parsed replay's player frames with each preset and report size and speed
+void benchPresets(const Parser& p) {
+  OutputSink sink;
+  sink.dir     = std::filesystem::temp_directory_path().string();
+  sink.pattern = "slippc-bench-{name}";
+  const std::string path = sink.path("frames.parquet");
+  for(unsigned i = 0; i < N_PARQUET_PRESETS; ++i) {
+    ParquetOptions o;
+    o.setPreset(PARQUET_PRESETS[i]);
+
+    auto start = std::chrono::steady_clock::now();
+    PlayerFrameWriter w;
+    if (!w.open(sink, o).ok() || !w.close(*p.replay()).ok()) {
+      WARN("Could not write " << path);
+      continue;
+    }
+    double write = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+
+    start = std::chrono::steady_clock::now();
+    bool scanned = scanFrames(path);
+    double scan  = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(path, ec);
+    std::cout << "  " << std::left << std::setw(9) << PARQUET_PRESETS[i] << std::right
+      << " write " << (write*1000) << " ms, "
+      << (ec ? 0 : size) << " bytes, scan ";
+    if (scanned) {
+      std::cout << (scan*1000) << " ms" << std::endl;
+    } else {
+      std::cout << "failed" << std::endl;
+    }
+  }
+  std::filesystem::remove(path);
+}
+
+int runbench(int argc, char** argv) {
+  if (argc < 2 || cmdOptionExists(argv, argv+argc, "-h")) {
+    printUsage();
+    return 0;
+  }
+
+  unsigned iterations = 20;
+  unsigned threads    = 1;
+  bool     summary    = cmdOptionExists(argv, argv+argc, "-s");
+  bool     presets    = cmdOptionExists(argv, argv+argc, "-w");
+  char* nlevel = getCmdOption(argv, argv+argc, "-n");
+  char* plevel = getCmdOption(argv, argv+argc, "-p");
+  char* dlevel = getCmdOption(argv, argv+argc, "-d");
+  if (nlevel) {
+    iterations = std::max(1,atoi(nlevel));
+  }
+  if (plevel) {
+    threads = std::max(0,atoi(plevel));
+  }
+  if (dlevel) {
+    _debug = atoi(dlevel);
+  }
+
+  for(int i = 1; i < argc; ++i) {
+    if (argv[i][0] == '-') {
+      i += (argv[i][1] != 's' && argv[i][1] != 'w');  //Skip option and its argument (if any)
+      continue;
+    }
+    const char* path = argv[i];
+    uint32_t events  = countEvents(path);
+    uint64_t bytes   = 0;
+    uint32_t frames  = 0;
+
+    double best = 0, total = 0;
+    for(unsigned n = 0; n < iterations; ++n) {
+      auto start = std::chrono::steady_clock::now();
+      Parser p(_debug);
+      p.setThreads(threads);
+      p.setSummaryOnly(summary);
+      if (not p.load(path)) {
+        FAIL("Could not parse " << path);
+        return 1;
+      }
+      double secs = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+      total  += secs;
+      best    = (n == 0 || secs < best) ? secs : best;
+      frames  = p.replay()->frame_count;
+    }
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    bytes = in.tellg();
+
+    std::cout << std::fixed << std::setprecision(2)
+      << path << ": " << events << " events, " << frames << " frames, " << bytes << " bytes" << std::endl
+      << "  best " << (best*1000) << " ms, mean " << (total*1000/iterations) << " ms over " << iterations << " runs" << std::endl
+      << "  " << (events/best/1e6) << " M events/s, "
+      << (frames/best/1e3) << " K frames/s, "
+      << (bytes/best/(1024*1024)) << " MiB/s" << std::endl;
+
+    if (presets && !summary) {
+      Parser p(_debug);
+      p.setThreads(threads);
+      if (p.load(path)) {
+        benchPresets(p);
+      }
+    }
+  }
+  return 0;
+}
+
+}
+
+int main(int argc, char** argv) {
+  return slip::runbench(argc,argv);
+}
@@ -0,0 +1,163 @@
+#ifndef DECODERS_H_
+#define DECODERS_H_
+
+#include "util.h"
+#include "replay.h"
+#include "schema.h"
+
+// Frame and item event decoders, specialized at compile time for each
+//   range of Slippi versions that share a payload layout
+
+namespace slip {
+
+//Each tier is the first Slippi version that added fields to a frame or item event
+enum SchemaTier : unsigned {
+  TIER_0_1,
+  TIER_0_2,   //Post: action state frame counter
+  TIER_1_2,   //Pre:  raw UCF x analog
+  TIER_1_4,   //Pre:  damage
+  TIER_2_0,   //Post: state bit flags, hitstun, airborne, ground, jumps, l cancel
+  TIER_2_1,   //Post: hurtbox state
+  TIER_3_2,   //Item: misc flags
+  TIER_3_5,   //Post: self-induced and attack-induced velocities
+  TIER_3_6,   //Item: owner
+  TIER_3_8,   //Post: hitlag
+  TIER_3_11,  //Post: animation index
+  TIER_COUNT
+};
+
+//Determine the schema tier for a replay (parameter names match the MIN_VERSION macro)
+inline SchemaTier schemaTier(uint8_t _slippi_maj, uint8_t _slippi_min, uint8_t _slippi_rev) {
+  if (MIN_VERSION(3,11,0)) { return TIER_3_11; }
+  if (MIN_VERSION(3,8,0))  { return TIER_3_8;  }
+  if (MIN_VERSION(3,6,0))  { return TIER_3_6;  }
+  if (MIN_VERSION(3,5,0))  { return TIER_3_5;  }
+  if (MIN_VERSION(3,2,0))  { return TIER_3_2;  }
+  if (MIN_VERSION(2,1,0))  { return TIER_2_1;  }
+  if (MIN_VERSION(2,0,0))  { return TIER_2_0;  }
+  if (MIN_VERSION(1,4,0))  { return TIER_1_4;  }
+  if (MIN_VERSION(1,2,0))  { return TIER_1_2;  }
+  if (MIN_VERSION(0,2,0))  { return TIER_0_2;  }
+  return TIER_0_1;
+}
+
+//Pre / post frame decoders write frame f of a player's columns
+template <SchemaTier T>
+inline void decodePreFrame(char* ev, FrameColumns &c, uint32_t f) {
+  c.follower.set(f, uint8_t(ev[O_FOLLOWER]) > 0);
+  c.alive.set(f, true);
+  c.seed[f]           = readBE4U(&ev[O_RNG_PRE]);
+  c.action_pre[f]     = readBE2U(&ev[O_ACTION_PRE]);
+  c.pos_x_pre[f]      = readBE4F(&ev[O_XPOS_PRE]);
+  c.pos_y_pre[f]      = readBE4F(&ev[O_YPOS_PRE]);
+  c.face_dir_pre[f]   = readBE4F(&ev[O_FACING_PRE]);
+  c.joy_x[f]          = readBE4F(&ev[O_JOY_X]);
+  c.joy_y[f]          = readBE4F(&ev[O_JOY_Y]);
+  c.c_x[f]            = readBE4F(&ev[O_CX]);
+  c.c_y[f]            = readBE4F(&ev[O_CY]);
+  c.trigger[f]        = readBE4F(&ev[O_TRIGGER]);
+  c.buttons[f]        = readBE2U(&ev[O_BUTTONS]);
+  c.phys_l[f]         = readBE4F(&ev[O_PHYS_L]);
+  c.phys_r[f]         = readBE4F(&ev[O_PHYS_R]);
+  if constexpr (T >= TIER_1_2) {
+    c.ucf_x[f]        = uint8_t(ev[O_UCF_ANALOG]);
+  }
+  if constexpr (T >= TIER_1_4) {
+    c.percent_pre[f]  = readBE4F(&ev[O_DAMAGE_PRE]);
+  }
+}
+
+template <SchemaTier T>
+inline void decodePostFrame(char* ev, FrameColumns &c, uint32_t f) {
+  c.char_id[f]        = uint8_t(ev[O_INT_CHAR_ID]);
+  c.action_post[f]    = readBE2U(&ev[O_ACTION_POST]);
+  c.pos_x_post[f]     = readBE4F(&ev[O_XPOS_POST]);
+  c.pos_y_post[f]     = readBE4F(&ev[O_YPOS_POST]);
+  c.face_dir_post[f]  = readBE4F(&ev[O_FACING_POST]);
+  c.percent_post[f]   = readBE4F(&ev[O_DAMAGE_POST]);
+  c.shield[f]         = readBE4F(&ev[O_SHIELD]);
+  c.hit_with[f]       = uint8_t(ev[O_LAST_HIT_ID]);
+  c.combo[f]          = uint8_t(ev[O_COMBO]);
+  c.hurt_by[f]        = uint8_t(ev[O_LAST_HIT_BY]);
+  c.stocks[f]         = uint8_t(ev[O_STOCKS]);
+  if constexpr (T >= TIER_0_2) {
+    c.action_fc[f]    = readBE4F(&ev[O_ACTION_FRAMES]);
+  }
+  if constexpr (T >= TIER_2_0) {
+    c.flags_1[f]      = uint8_t(ev[O_STATE_BITS_1]);
+    c.flags_2[f]      = uint8_t(ev[O_STATE_BITS_2]);
+    c.flags_3[f]      = uint8_t(ev[O_STATE_BITS_3]);
+    c.flags_4[f]      = uint8_t(ev[O_STATE_BITS_4]);
+    c.flags_5[f]      = uint8_t(ev[O_STATE_BITS_5]);
+    c.hitstun[f]      = readBE4F(&ev[O_HITSTUN]);
+    c.airborne.set(f, bool(ev[O_AIRBORNE]));
+    c.ground_id[f]    = readBE2U(&ev[O_GROUND_ID]);
+    c.jumps[f]        = uint8_t(ev[O_JUMPS]);
+    c.l_cancel[f]     = uint8_t(ev[O_LCANCEL]);
+  }
+  if constexpr (T >= TIER_2_1) {
+    c.hurtbox[f]      = uint8_t(ev[O_HURTBOX]);
+  }
+  if constexpr (T >= TIER_3_5) {
+    c.self_air_x[f]   = readBE4F(&ev[O_SELF_AIR_X]);
+    c.self_air_y[f]   = readBE4F(&ev[O_SELF_AIR_Y]);
+    c.attack_x[f]     = readBE4F(&ev[O_ATTACK_X]);
+    c.attack_y[f]     = readBE4F(&ev[O_ATTACK_Y]);
+    c.self_grd_x[f]   = readBE4F(&ev[O_SELF_GROUND_X]);
+  }
+  if constexpr (T >= TIER_3_8) {
+    c.hitlag[f]       = readBE4F(&ev[O_HITLAG]);
+  }
+  if constexpr (T >= TIER_3_11) {
+    c.anim_index[f]   = readBE4U(&ev[O_ANIM_INDEX]);
+  }
+}
+
+template <SchemaTier T>
+inline void decodeItemFrame(char* ev, SlippiItemFrame &f) {
+  f.frame           = readBE4S(&ev[O_FRAME]);
+  f.state           = uint8_t(ev[O_ITEM_STATE]);
+  f.face_dir        = readBE4F(&ev[O_ITEM_FACING]);
+  f.xvel            = readBE4F(&ev[O_ITEM_XVEL]);
+  f.yvel            = readBE4F(&ev[O_ITEM_YVEL]);
+  f.xpos            = readBE4F(&ev[O_ITEM_XPOS]);
+  f.ypos            = readBE4F(&ev[O_ITEM_YPOS]);
+  f.damage          = readBE2U(&ev[O_ITEM_DAMAGE]);
+  f.expire          = readBE4F(&ev[O_ITEM_EXPIRE]);
+  if constexpr (T >= TIER_3_2) {
+    f.flags_1       = uint8_t(ev[O_ITEM_MISC]);
+    f.flags_2       = uint8_t(ev[O_ITEM_MISC+1]);
+    f.flags_3       = uint8_t(ev[O_ITEM_MISC+2]);
+    f.flags_4       = uint8_t(ev[O_ITEM_MISC+3]);
+  }
+  if constexpr (T >= TIER_3_6) {
+    f.owner         = int8_t(ev[O_ITEM_OWNER]);
+  }
+}
+
+//Decoders for a single schema tier, selected once per replay after the game start event
+struct FrameDecoders {
+  void (*pre)(char*, FrameColumns&, uint32_t);
+  void (*post)(char*, FrameColumns&, uint32_t);
+  void (*item)(char*, SlippiItemFrame&);
+};
+
+#define TIER_DECODERS(t) { decodePreFrame<t>, decodePostFrame<t>, decodeItemFrame<t> }
+const FrameDecoders FRAME_DECODERS[TIER_COUNT] = {
+  TIER_DECODERS(TIER_0_1),
+  TIER_DECODERS(TIER_0_2),
+  TIER_DECODERS(TIER_1_2),
+  TIER_DECODERS(TIER_1_4),
+  TIER_DECODERS(TIER_2_0),
+  TIER_DECODERS(TIER_2_1),
+  TIER_DECODERS(TIER_3_2),
+  TIER_DECODERS(TIER_3_5),
+  TIER_DECODERS(TIER_3_6),
+  TIER_DECODERS(TIER_3_8),
+  TIER_DECODERS(TIER_3_11),
+};
+#undef TIER_DECODERS
+
+}
+
+#endif /* DECODERS_H_ */
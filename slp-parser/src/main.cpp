@@ -2,6 +2,13 @@
 #include <sys/stat.h>
 #include <filesystem>
 #include <iostream>
+#include <vector>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <io.h>     //_setmode()
+#include <fcntl.h>  //_O_BINARY
+#endif
 
 #include <arrow/api.h>
 #include <parquet/arrow/writer.h>
@@ -62,11 +69,31 @@ bool cmdOptionExists(char** begin, char** end, const std::string& option) {
 
 void printUsage() {
   std::cout
-    << "Usage: slippc -i <infile> [-j <jsonfile>] [-a <analysisfile>] [-f] [-d <debuglevel>] [-h]:" << std::endl
-    << "  -i        Set input file (can be .slp or a whole directory)" << std::endl
+    << "Usage: slippc -i <infile> [-n <name>] [-j <jsonfile>] [-a <analysisfile>] [-o <template>] [-H] [-m <MiB>] [-f] [-s] [-p <threads>] [-r] [-z <compression>] [-g <rows>] [-b <bytes>] [-x <columns>] [-t] [-d <debuglevel>] [-h]:" << std::endl
+    << "  -i        Set input file (can be .slp or a whole directory; use \"-\" for stdin)" << std::endl
+    << "  -n        Name to record for the input replay (defaults to <infile>)" << std::endl
     << "  -j        Output <infile> in .json format to <jsonfile> (use \"-\" for stdout)" << std::endl
+    << "              (a directory: settings, frames, and analysis files are all written under it)" << std::endl
+    << "  -o        Name output files with <template>, where {replay} is the replay's name and {name} the file's" << std::endl
+    << "              (default {name}, or {replay}/{name} when <infile> is a directory)" << std::endl
+    << "  -H        Lay files out in Hive partitions ({table}/stage=<id>/date=<yyyy-mm-dd>/chars=<ids>/{replay}_{name})" << std::endl
+    << "              and list them in partitions.jsonl, so queries filtered by stage, date, or character read less" << std::endl
+    << "  -m        When <infile> is a directory, append every replay's Parquet output to shared files," << std::endl
+    << "              starting a new file (frames-00000.parquet, frames-00001.parquet, ...) every <MiB> MiB" << std::endl
     << "  -a        Output an analysis of <infile> in .json format to <analysisfile> (use \"-\" for stdout)" << std::endl
     << "  -f        When used with -j <jsonfile>, write full frame info (instead of just frame deltas)" << std::endl
+    << "  -s        When used with -j <jsonfile>, only write settings (skips reading frame data when possible)" << std::endl
+    << "  -p        Decode frames with <threads> threads (0 = one per core; default 1)" << std::endl
+    << "  -r        Write player frames to Parquet while parsing, a row group at a time (bounds memory use)" << std::endl
+    << std::endl
+    << "Parquet options:" << std::endl
+    << "  -z        Compression: a preset (legacy, fast, balanced, small; default fast) or <codec>[:<level>]" << std::endl
+    << "              (codec = uncompressed, snappy, gzip, brotli, zstd, or lz4)" << std::endl
+    << "  -g        Rows per row group (default " << slip::PARQUET_ROW_GROUP_ROWS << ")" << std::endl
+    << "  -b        Target data page size in bytes (default " << slip::PARQUET_PAGE_BYTES << ")" << std::endl
+    << "  -x        Comma-separated columns to write without dictionary encoding (\"all\" for every column)" << std::endl
+    << "  -t        Sort player frames by match, player, and frame, with page indexes and bloom filters" << std::endl
+    << "              (on match_id and action_post) so match / frame window / action lookups skip most pages" << std::endl
     << std::endl
     << "Debug options:" << std::endl
     << "  -d           Run at debug level <debuglevel> (show debug output)" << std::endl
@@ -77,20 +104,48 @@ void printUsage() {
 typedef struct _cmdoptions {
   char* dlevel       = nullptr;
   char* infile       = nullptr;
+  char* inname       = nullptr;
   char* outfile      = nullptr;
   char* analysisfile = nullptr;
+  char* pattern      = nullptr;
+  char* batchsize    = nullptr;
+  char* threads_arg  = nullptr;
+  char* codec        = nullptr;
+  char* rowgroup     = nullptr;
+  char* pagesize     = nullptr;
+  char* plaincols    = nullptr;
   bool  nodelta      = false;
+  bool  summary      = false;
   bool  dirmode      = false;
+  bool  stream       = false;
+  bool  sorted       = false;
+  bool  hive         = false;
   int   debug        = 0;
+  int   threads      = 1;
+  uint64_t batch_bytes = 0;
+  slip::ParquetBatch* batch = nullptr;  //Shared Parquet files for a directory run (owned by handleDirectory())
+  slip::PartitionManifest* manifest = nullptr;  //Partitions written so far with -H (owned by the caller of handleSingleFile())
 } cmdoptions;
 
 cmdoptions getCommandLineOptions(int argc, char** argv) {
   _cmdoptions c;
   c.dlevel       = getCmdOption(   argv, argv+argc, "-d");
   c.infile       = getCmdOption(   argv, argv+argc, "-i");
+  c.inname       = getCmdOption(   argv, argv+argc, "-n");
   c.outfile      = getCmdOption(   argv, argv+argc, "-j");
   c.analysisfile = getCmdOption(   argv, argv+argc, "-a");
+  c.pattern      = getCmdOption(   argv, argv+argc, "-o");
+  c.batchsize    = getCmdOption(   argv, argv+argc, "-m");
+  c.threads_arg  = getCmdOption(   argv, argv+argc, "-p");
+  c.codec        = getCmdOption(   argv, argv+argc, "-z");
+  c.rowgroup     = getCmdOption(   argv, argv+argc, "-g");
+  c.pagesize     = getCmdOption(   argv, argv+argc, "-b");
+  c.plaincols    = getCmdOption(   argv, argv+argc, "-x");
   c.nodelta      = cmdOptionExists(argv, argv+argc, "-f");
+  c.summary      = cmdOptionExists(argv, argv+argc, "-s");
+  c.stream       = cmdOptionExists(argv, argv+argc, "-r");
+  c.sorted       = cmdOptionExists(argv, argv+argc, "-t");
+  c.hive         = cmdOptionExists(argv, argv+argc, "-H");
   c.dirmode      = isDirectory(c.infile);
 
   if (c.dlevel) {
@@ -108,9 +163,85 @@ cmdoptions getCommandLineOptions(int argc, char** argv) {
     DOUT1("Running at debug level " << +c.debug);
   }
 
+  if (c.threads_arg) {
+    c.threads = std::max(0,atoi(c.threads_arg));
+  }
+
+  if (c.batchsize) {
+    c.batch_bytes = uint64_t(std::max(1,atoi(c.batchsize))) << 20;
+  }
+
+  if (c.hive && c.stream) {
+    WARN("A replay's partition isn't known until it has been read; ignoring -r");
+    c.stream = false;
+  }
+
   return c;
 }
 
+//Parquet options from the command line: a preset or codec first, then any overrides
+slip::ParquetOptions getParquetOptions(const cmdoptions &c) {
+  slip::ParquetOptions o;
+  if (c.codec && !o.setPreset(c.codec) && !o.setCodec(c.codec)) {
+    WARN("Unknown Parquet preset or invalid codec '" << c.codec << "'; using " << o.codec);
+  }
+  if (c.rowgroup) {
+    o.row_group_rows = std::max(1,atoi(c.rowgroup));
+  }
+  if (c.pagesize) {
+    o.page_bytes = std::max(1,atoi(c.pagesize));
+  }
+  if (c.plaincols) {
+    o.setPlainColumns(c.plaincols);
+  }
+  o.sorted = c.sorted;
+  return o;
+}
+
+//Where one replay's output files go: under the -j directory (or beside the analysis file),
+//  named by the -o template so replays sharing a directory don't overwrite each other
+//  (with -H, in the loaded replay's partition)
+slip::OutputSink getOutputSink(const cmdoptions &c, const slip::SlippiReplay* r = nullptr) {
+  slip::OutputSink sink;
+  if (c.outfile && !(c.outfile[0] == '-' && c.outfile[1] == '\0')) {
+    sink.dir = c.outfile;
+  } else if (c.analysisfile && !(c.analysisfile[0] == '-' && c.analysisfile[1] == '\0')) {
+    sink.dir = PATH(c.analysisfile).parent_path().string();
+  }
+  if (sink.dir.empty()) {
+    sink.dir = ".";
+  }
+  if (c.pattern) {
+    sink.pattern = c.pattern;
+  } else if (c.hive) {
+    sink.pattern = slip::HIVE_PATTERN;
+  } else if (c.dirmode) {
+    sink.pattern = "{replay}/{name}";
+  }
+  sink.replay = PATH(c.inname ? c.inname : c.infile).stem().string();
+  if (c.hive && r) {
+    sink.partition = r->partition();
+    sink.manifest  = c.manifest;
+  }
+  return sink;
+}
+
+//Write the partitions that -H put files in to partitions.jsonl at the top of the output
+int writeManifest(const cmdoptions &c, const slip::PartitionManifest &manifest) {
+  if (manifest.size() == 0) {
+    return 0;
+  }
+  slip::OutputSink sink = getOutputSink(c);
+  sink.pattern = "{name}";
+  arrow::Status status = sink.writeText("partitions.jsonl", manifest.asJsonl());
+  if (!status.ok()) {
+    WARN("Could not write partition manifest: " << status.ToString());
+    return 1;
+  }
+  DOUT1(" Wrote " << manifest.size() << " partitions to " << sink.path("partitions.jsonl"));
+  return 0;
+}
+
 #if GUI_ENABLED == 1
   void getGUIOptions(cmdoptions &c) {
     if (_debug < 1) {
@@ -157,25 +288,24 @@ inline void cleanupCommandOptions(cmdoptions &c) {
 
 
 
-int handleAnalysis(const cmdoptions &c, const int debug, slip::Parser &p) {
+int handleAnalysis(const cmdoptions &c, const int debug, slip::Parser &p, slip::Analysis &a) {
   DOUT1(" Analyzing");
-  slip::Analysis *a  = p.analyze();
+  p.analyze(a);
 
-  if (a->success) {
+  if (a.success) {
     if (c.analysisfile[0] == '-' && c.analysisfile[1] == '\0') {
       if (debug) {
         DOUT1("  Writing analysis to stdout");
       }
-      std::cout << a->asJson() << std::endl;
+      std::cout << a.asJson() << std::endl;
     } else {
       if (debug) {
         DOUT1("  Saving analysis to file");
       }
-      a->save(c.outfile);
+      a.save(getOutputSink(c,p.replay()), getParquetOptions(c), c.batch);
     }
   }
 
-  delete a;
   return 0;
 }
 
@@ -190,19 +320,42 @@ int handleJson(const cmdoptions &c, const int debug, slip::Parser &p) {
     if (debug) {
       DOUT1("  Saving Slippi JSON data to file");
     }
-    p.save(c.outfile, c.infile, !c.nodelta);
+    p.save(getOutputSink(c,p.replay()), c.inname ? c.inname : c.infile, !c.nodelta);
   }
   return 0;
 }
 
-int handleSingleFile(const cmdoptions &c, const int debug) {
+bool readStdin(std::vector<char> &buffer) {
+#ifdef _WIN32
+  _setmode(_fileno(stdin), _O_BINARY);
+#endif
+  char chunk[65536];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), stdin)) > 0) {
+    buffer.insert(buffer.end(), chunk, chunk+n);
+  }
+  return !ferror(stdin);
+}
+
+//Process one file with a Parser and Analysis that may be reused across files
+int handleSingleFile(const cmdoptions &c, const int debug, slip::Parser &p, slip::Analysis &a) {
   int reta = 0;  //return value from analysis phase
   int retj = 0;  //return value from jsonoutput phase
 
   if (c.outfile || c.analysisfile) {
     DOUT1(" Parsing");
-    slip::Parser p(debug);
-    if (not p.load((std::string("/tmp/") + c.infile).c_str())) {
+    p.setStreamSink(getOutputSink(c));
+    if (c.infile[0] == '-' && c.infile[1] == '\0') {
+      std::vector<char> replay;
+      if (not readStdin(replay)) {
+        FAIL("    Could not read replay from stdin; exiting");
+        return 2;
+      }
+      if (replay.size() > UINT32_MAX || not p.loadFromBuffer(replay.data(), replay.size(), c.inname ? c.inname : "-")) {
+        FAIL("    Could not load input; exiting");
+        return 2;
+      }
+    } else if (not p.load(c.infile)) {
       FAIL("    Could not load input; exiting");
       return 2;
     }
@@ -211,16 +364,36 @@ int handleSingleFile(const cmdoptions &c, const int debug) {
       retj = handleJson(c,debug,p);
     }
     if (c.analysisfile) {
-      reta = handleAnalysis(c,debug,p);
+      reta = handleAnalysis(c,debug,p,a);
     }
   }
 
   if (debug) {
     DOUT1(" Cleaning up");
   }
+  p.reset();  //Let go of the replay now, but keep the parser's buffers for the next file
   return reta+retj;
 }
 
+//Set up a Parser for the given options
+inline void configureParser(const cmdoptions &c, slip::Parser &p) {
+  p.setThreads(c.threads);
+  p.setSummaryOnly(c.summary && !c.analysisfile);  //Analysis needs every frame
+  p.setFrameStreaming(c.stream);
+  p.setParquetOptions(getParquetOptions(c));
+}
+
+int handleSingleFile(const cmdoptions &c, const int debug) {
+  slip::Parser   p(debug);
+  slip::Analysis a(0);
+  configureParser(c,p);
+  slip::PartitionManifest manifest;
+  cmdoptions c2 = c;
+  c2.manifest   = &manifest;
+  int ret = handleSingleFile(c2,debug,p,a);
+  return ret+writeManifest(c,manifest);
+}
+
 int handleDirectory(const cmdoptions &c, const int debug) {
   // verify all of our input and output directories are valid (not files + proper write permissions)
   if (!(c.outfile || c.analysisfile)) {
@@ -236,6 +409,28 @@ int handleDirectory(const cmdoptions &c, const int debug) {
     return -2;
   }
 
+  // one parser and analysis for the whole directory, so buffers sized for
+  //   one replay are reused for the next instead of being reallocated
+  slip::Parser   p(debug);
+  slip::Analysis a(0);
+  configureParser(c,p);
+
+  // with -m, every replay's Parquet output is appended to a few large shared files
+  //   (named from the input directory) instead of a small set per replay
+  std::unique_ptr<slip::ParquetBatch> batch;
+  if (c.batch_bytes) {
+    slip::OutputSink sink = getOutputSink(c);
+    sink.pattern = c.pattern ? c.pattern : (c.hive ? "{table}/{name}" : "{name}");
+    if (c.hive) {
+      WARN("Shared Parquet files hold replays from many partitions, so they're written unpartitioned");
+    }
+    sink.replay  = PATH(c.infile).filename().string();
+    batch.reset(new slip::ParquetBatch(sink, getParquetOptions(c), c.batch_bytes));
+    p.setParquetBatch(batch.get());
+  }
+
+  slip::PartitionManifest manifest;
+
   // find all slippi files in a directory
   for (const f_entry & entry : f_iter(std::string(c.infile))) {
     std::string base  = entry.path().filename();
@@ -244,8 +439,10 @@ int handleDirectory(const cmdoptions &c, const int debug) {
       cmdoptions c2;
       copyCommandOptions(c,c2);
       stringtoChars((entry.path()).string(),&(c2.infile));
+      c2.batch    = batch.get();
+      c2.manifest = &manifest;
       if(c2.outfile) {
-        stringtoChars((PATH(c.outfile) / PATH(base+".json")).string(),&(c2.outfile));
+        stringtoChars(std::string(c.outfile),&(c2.outfile));  //Files are kept apart by the -o template
       }
       if(c2.analysisfile) {
         stringtoChars((PATH(c.analysisfile) / PATH(noext+"-analysis.json")).string(),&(c2.analysisfile));
@@ -255,14 +452,24 @@ int handleDirectory(const cmdoptions &c, const int debug) {
       // std::cout << "    -j " << c2.outfile << std::endl;
       // std::cout << "    -a " << c2.analysisfile << std::endl;
       INFO("Processing file " << CYN << c2.infile << BLN);
-      int ret = handleSingleFile(c2,debug);
+      int ret = handleSingleFile(c2,debug,p,a);
       if (ret != 0) {
         WARN("  Encountered errors processing input file " << RED << c2.infile << BLN);
       }
       cleanupCommandOptions(c2);
     }
   }
-  return 0;
+
+  if (batch) {
+    p.setParquetBatch(nullptr);
+    arrow::Status status = batch->close();
+    if (!status.ok()) {
+      WARN("Could not finish shared Parquet files: " << status.ToString());
+      return 1;
+    }
+    INFO("Wrote " << batch->frames.rows() << " frame rows to " << batch->frames.files() << " frames file(s)");
+  }
+  return writeManifest(c,manifest);
 }
 
 int run(int argc, char** argv) {
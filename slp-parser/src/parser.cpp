@@ -1,23 +1,133 @@
 #include "parser.h"
 #include <iostream>
 
+#ifndef _WIN32
+#include <fcntl.h>    //open()
+#include <unistd.h>   //close()
+#include <sys/mman.h> //mmap(), madvise()
+#endif
+
 namespace slip {
 
   Parser::Parser(int debug_level) {
     _debug = debug_level;
     _bp    = 0;
+    _replay.arena = &_arena;
   }
 
   Parser::~Parser() {
-    if (_rb != nullptr) {
-      delete [] _rb;
-    }
+    _releaseBuffer();
     _cleanup();
+    delete [] _rb_heap;
+  }
+
+  void Parser::setThreads(unsigned threads) {
+    if (threads == 0) {
+      threads = std::max(1u,std::thread::hardware_concurrency());
+    }
+    _threads = threads;
+  }
+
+  void Parser::setExactSizing(bool exact) {
+    _exact_sizing = exact;
+  }
+
+  void Parser::setSummaryOnly(bool summary) {
+    _summary_only = summary;
+  }
+
+  void Parser::setFrameCallback(FrameCallback on_frame) {
+    _on_frame = on_frame;
+  }
+
+  void Parser::setFrameStreaming(bool stream) {
+    _stream_frames = stream;
+  }
+
+  void Parser::setStreamSink(const OutputSink& sink) {
+    _stream_sink = sink;
+  }
+
+  void Parser::setParquetBatch(ParquetBatch* batch) {
+    _batch = batch;
+  }
+
+  void Parser::setParquetOptions(const ParquetOptions& o) {
+    _parquet = o;
+  }
+
+  void Parser::reset() {
+    _releaseBuffer();
+    _resetReplay();
   }
 
   bool Parser::load(const char* replayfilename) {
     DOUT1("  Loading " << replayfilename);
+    reset();
     _replay.original_file = std::string(replayfilename);
+
+    //Map regular files straight from the page cache; fall back to
+    //  reading into a heap buffer for pipes, devices, and Windows
+    if (not this->_mapFile(replayfilename)) {
+      if (not this->_readFile(replayfilename)) {
+        return false;
+      }
+    }
+
+    bool status = this->_parse();
+    return status;
+  }
+
+  bool Parser::loadFromBuffer(const char* buffer, uint32_t length, const char* name) {
+    DOUT1("  Loading " << length << " bytes from memory");
+    reset();
+    _replay.original_file = std::string(name);
+
+    if (length < MIN_REPLAY_LENGTH) {
+      FAIL("  Buffer is too short to be a valid Slippi replay");
+      return false;
+    }
+
+    //The parser never writes to _rb, so the caller's bytes are read in place
+    _file_size = length;
+    _rb        = const_cast<char*>(buffer);
+    _rb_source = RB_BORROWED;
+
+    bool status = this->_parse();
+    _releaseBuffer();  //Don't hang on to memory we don't own
+    return status;
+  }
+
+  bool Parser::_mapFile(const char* replayfilename) {
+#ifdef _WIN32
+    return false;
+#else
+    int fd = open(replayfilename, O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size < MIN_REPLAY_LENGTH || st.st_size > UINT32_MAX) {
+      close(fd);
+      return false;  //Let the heap path deal with (and report on) anything unusual
+    }
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  //The mapping keeps its own reference to the file
+    if (addr == MAP_FAILED) {
+      DOUT1("  Could not map " << replayfilename << "; reading into memory instead");
+      return false;
+    }
+    madvise(addr, st.st_size, _summary_only ? MADV_RANDOM : MADV_SEQUENTIAL);  //Summaries only touch both ends
+
+    _file_size  = st.st_size;
+    _rb         = static_cast<char*>(addr);  //Read-only; nothing in the parser writes to _rb
+    _rb_source  = RB_MAPPED;
+    DOUT1("  File Size: " << +_file_size << " (memory-mapped)");
+    return true;
+#endif
+  }
+
+  bool Parser::_readFile(const char* replayfilename) {
     std::ifstream myfile;
     myfile.open(replayfilename,std::ios::binary | std::ios::in);
     if (myfile.fail()) {
@@ -26,7 +136,21 @@ namespace slip {
     }
 
     myfile.seekg(0, myfile.end);
-    _file_size = myfile.tellg();
+    std::streamoff size = myfile.tellg();
+    if (size < 0) {  //Not seekable (e.g., a pipe), so just read until EOF
+      myfile.clear();
+      std::string contents((std::istreambuf_iterator<char>(myfile)), std::istreambuf_iterator<char>());
+      myfile.close();
+      _file_size = contents.size();
+      if (_file_size < MIN_REPLAY_LENGTH) {
+        FAIL("  File " << replayfilename << " is too short to be a valid Slippi replay");
+        return false;
+      }
+      DOUT1("  File Size: " << +_file_size);
+      memcpy(_heapBuffer(_file_size),contents.data(),_file_size);
+      return true;
+    }
+    _file_size = size;
     if (_file_size < MIN_REPLAY_LENGTH) {
       FAIL("  File " << replayfilename << " is too short to be a valid Slippi replay");
       return false;
@@ -34,12 +158,34 @@ namespace slip {
     DOUT1("  File Size: " << +_file_size);
     myfile.seekg(0, myfile.beg);
 
-    _rb = new char[_file_size];
-    myfile.read(_rb,_file_size);
+    myfile.read(_heapBuffer(_file_size),_file_size);
     myfile.close();
+    return true;
+  }
 
-    bool status = this->_parse();
-    return status;
+  char* Parser::_heapBuffer(uint32_t size) {
+    if (size > _rb_heap_size) {
+      delete [] _rb_heap;
+      _rb_heap      = new char[size];
+      _rb_heap_size = size;
+    }
+    _rb        = _rb_heap;
+    _rb_source = RB_HEAP;
+    return _rb;
+  }
+
+  void Parser::_releaseBuffer() {
+    if (_rb == nullptr) {
+      return;
+    }
+    switch(_rb_source) {
+#ifndef _WIN32
+      case RB_MAPPED:   munmap(_rb, _file_size); break;
+#endif
+      default:          break;  //Heap buffer is kept for the next replay; borrowed memory isn't ours
+    }
+    _rb        = nullptr;
+    _rb_source = RB_HEAP;
   }
 
   bool Parser::_parse() {
@@ -52,7 +198,9 @@ namespace slip {
       WARN("  Failed to parse event descriptions");
       return false;
     }
-    if (not this->_parseEvents()) {
+    if (_summary_only && this->_parseSummary()) {
+      DOUT1("  Skipped frame data");
+    } else if (not this->_parseEvents()) {
       WARN("  Failed to parse events proper");
       return false;
     }
@@ -60,6 +208,11 @@ namespace slip {
       WARN("  Failed to parse metadata");
       //Non-fatal if we can't parse metadata, so don't need to return false
     }
+    _finish();
+    return true;
+  }
+
+  void Parser::_finish() {
     if(!_game_end_found) {
       WARN_CORRUPT("  No game end event found");
       ++_replay.errors;
@@ -69,6 +222,204 @@ namespace slip {
     } else {
       WARN("  Replay parsed with " << _replay.errors << " errors");
     }
+  }
+
+  void Parser::beginStream(FrameCallback on_frame) {
+    DOUT1("  Starting streamed replay");
+    _releaseBuffer();
+    _resetReplay();
+    _sb.clear();
+    _bp             = 0;
+    _streaming      = true;
+    _stream_state   = SS_HEADER;
+    _stream_emitted = 0;
+    _on_frame       = on_frame;
+  }
+
+  bool Parser::feed(const char* data, uint32_t length) {
+    if (not _streaming) {
+      FAIL("  Received replay data before beginStream()");
+      return false;
+    }
+    _sb.insert(_sb.end(), data, data+length);
+    _rb        = _sb.data();
+    _rb_source = RB_BORROWED;
+    _file_size = _sb.size();
+
+    bool status = this->_parseStream();
+
+    //Drop everything we've consumed, so the buffer only ever holds a partial event (or the metadata)
+    _sb.erase(_sb.begin(), _sb.begin()+_bp);
+    _bp = 0;
+    _releaseBuffer();
+    return status;
+  }
+
+  bool Parser::endStream() {
+    if (not _streaming) {
+      FAIL("  Ended a stream before beginStream()");
+      return false;
+    }
+    _rb        = _sb.data();
+    _rb_source = RB_BORROWED;
+    _file_size = _sb.size();
+
+    if (_stream_state == SS_METADATA) {
+      if (not this->_parseMetadata()) {
+        WARN("  Failed to parse metadata");
+      }
+    } else {
+      DOUT1("  Stream ended before the raw data did; skipping metadata");
+    }
+    bool status = (_stream_state == SS_EVENTS || _stream_state == SS_METADATA);
+    if (status) {
+      _emitFrames(_replay.last_frame);
+      _finish();
+    }
+
+    _releaseBuffer();
+    _sb.clear();
+    _sb.shrink_to_fit();
+    _streaming = false;
+    _on_frame  = nullptr;
+    return status;
+  }
+
+  bool Parser::_parseStream() {
+    for(;;) {
+      uint32_t avail = _sb.size() - _bp;
+      switch(_stream_state) {
+        case SS_HEADER:
+          if (avail < N_HEADER_BYTES) {
+            return true;
+          }
+          if (not this->_parseHeader()) {
+            return false;
+          }
+          if (_length_raw_start == 0) {  //Raw length isn't written until the recording finishes
+            _length_raw = UINT32_MAX;
+          }
+          _stream_state = SS_PAYLOADS;
+          break;
+        case SS_PAYLOADS:
+          if (avail < 2 || avail < 1+unsigned(uint8_t(_rb[_bp+1]))) {
+            return true;
+          }
+          if (not this->_parseEventDescriptions()) {
+            return false;
+          }
+          _stream_state = SS_EVENTS;
+          break;
+        case SS_EVENTS: {
+          if (_length_raw == 0) {
+            _stream_state = SS_METADATA;
+            break;
+          }
+          if (avail < 1) {
+            return true;
+          }
+          unsigned ev_code = uint8_t(_rb[_bp]);
+          unsigned shift   = _payload_sizes[ev_code];
+          if (shift == 0) {
+            WARN_CORRUPT("    Uninitialized event " << hex(ev_code) << " encountered");
+            ++_replay.errors;
+            return false;
+          }
+          if (shift > _length_raw) {
+            WARN_CORRUPT("    Event byte offset exceeds raw data length");
+            ++_replay.errors;
+            return false;
+          }
+          if (avail < shift) {
+            return true;  //Wait for the rest of the event
+          }
+          if (not this->_parseEvent(ev_code)) {
+            return false;
+          }
+          _emitFinalized(ev_code);
+          _length_raw -= shift;
+          _bp         += shift;
+          if (ev_code == Event::GAME_END && _length_raw_start == 0) {
+            _stream_state = SS_METADATA;  //Nothing but metadata after the game ends
+          }
+          break;
+        }
+        case SS_METADATA:
+          return true;  //Metadata is parsed all at once in endStream()
+      }
+    }
+  }
+
+  void Parser::_emitFinalized(unsigned ev_code) {
+    //Figure out which frames can no longer change; replays with rollback info (3.7.0+)
+    //  say so in each bookend, and when loading a whole file, reaching a frame's final copy
+    //  means every earlier frame is final too; otherwise assume a frame is done once the next one starts
+    bool finalized = (_payload_sizes[Event::BOOKEND] >= O_ROLLBACK_FRAME+4);
+    bool mapped    = not _final_segment.empty();
+    switch(ev_code) {
+      case Event::FRAME_START:
+        if (mapped && not _superseded) {
+          _emitFrames(readBE4S(&_rb[_bp+O_FRAME])-1);
+        }
+        break;
+      case Event::PRE_FRAME:
+        if (not finalized && not mapped) {
+          _emitFrames(readBE4S(&_rb[_bp+O_FRAME])-1);
+        }
+        break;
+      case Event::BOOKEND:
+        if (finalized || not mapped || not _superseded) {
+          _emitFrames(readBE4S(&_rb[_bp+(finalized ? O_ROLLBACK_FRAME : O_BOOKEND_FRAME)]));
+        }
+        break;
+      case Event::GAME_END:
+        _emitFrames(_replay.last_frame);
+        break;
+      default:
+        break;
+    }
+  }
+
+  void Parser::_emitFrames(int32_t last_fnum) {
+    if (_on_frame == nullptr && not _frame_writer.isOpen()) {
+      return;
+    }
+    uint32_t start = _stream_emitted;
+    for( ; int32_t(_stream_emitted) <= last_fnum-LOAD_FRAME && _stream_emitted < _replay.frame_count; ++_stream_emitted) {
+      if (_on_frame != nullptr) {
+        _on_frame(_replay,_stream_emitted);
+      }
+    }
+    if (_frame_writer.isOpen() && _stream_emitted > start) {
+      arrow::Status status = _frame_writer.write(_replay,_stream_emitted);
+      if (!status.ok()) {
+        WARN("  Error writing player frames to Parquet: " << status.ToString());
+      }
+    }
+  }
+
+  bool Parser::_frameInRange(int32_t fnum) {
+    if (fnum < LOAD_FRAME) {
+      FAIL_CORRUPT("    Frame index " << fnum << " less than " << +LOAD_FRAME);
+      return false;
+    }
+    if (fnum < _max_frames) {
+      return true;
+    }
+    if (not _streaming) {
+      FAIL_CORRUPT("    Frame index " << fnum
+        << " greater than max frames computed from reported raw size (" << _max_frames << ")");
+      return false;
+    }
+
+    //Double our frame storage until this frame fits
+    int32_t grown = _max_frames;
+    while (fnum >= grown) {
+      grown = LOAD_FRAME+2*(grown-LOAD_FRAME);
+    }
+    DOUT1("    Growing frame storage from " << (_max_frames-LOAD_FRAME) << " to " << (grown-LOAD_FRAME) << " frames");
+    _replay.growFrames(_max_frames,grown);
+    _max_frames = grown;
     return true;
   }
 
@@ -83,12 +434,12 @@ namespace slip {
       return false;
     }
     _length_raw_start = readBE4U(&_rb[_bp+11]);
-    if(_length_raw_start == 0) {  //TODO: this is /technically/ recoverable
+    if(_length_raw_start == 0 && !_streaming) {  //TODO: this is /technically/ recoverable
       WARN_CORRUPT("    0-byte raw data detected");
       ++_replay.errors;
     }
     DOUT1("    Raw portion = " << _length_raw_start << " bytes");
-    if (_length_raw_start > _file_size) {
+    if (_length_raw_start > _file_size && !_streaming) {
       WARN_CORRUPT("    Raw data size " << +_length_raw_start << " exceeds file size of " << _file_size << " bytes");
       ++_replay.errors;
       _length_raw_start = 0;
@@ -154,6 +505,24 @@ namespace slip {
       DOUT1("    Using remaining file size " << +_length_raw << " as raw bytes");
     }
 
+    _scanFrames();
+
+    //Write player frames out a row group at a time as they're finalized, rather than all at once at save()
+    if (_stream_frames) {
+      arrow::Status status = _batch ? _frame_writer.open(_batch->frames) : _frame_writer.open(_stream_sink,_parquet);
+      if (!status.ok()) {
+        WARN("  Could not open player frame output: " << status.ToString());
+      }
+    }
+
+    //With multiple threads, pre / post frame events are only validated and indexed
+    //  in this pass; everything else (game start, items, etc.) is still parsed in order
+    _index_frames = (_threads > 1);
+    if (_index_frames) {
+      unsigned frame_bytes = _payload_sizes[Event::PRE_FRAME]+_payload_sizes[Event::POST_FRAME];
+      _frame_events.reserve(2*(_length_raw/frame_bytes));
+    }
+
     bool success = true;
     for( ; _length_raw > 0; ) {
       unsigned ev_code = uint8_t(_rb[_bp]);
@@ -161,41 +530,223 @@ namespace slip {
       if (shift > _length_raw) {
         WARN_CORRUPT("    Event byte offset exceeds raw data length");
         ++_replay.errors;
-        return true;
-      }
-      switch(ev_code) { //Determine the event code
-        case Event::GAME_START:
-          success = _parseGameStart();
-          break;
-        case Event::PRE_FRAME:   success = _parsePreFrame();   break;
-        case Event::POST_FRAME:  success = _parsePostFrame();  break;
-        case Event::GAME_END:    success = _parseGameEnd();    break;
-        case Event::ITEM_UPDATE: success = _parseItemUpdate(); break;
-        case Event::FOD_PLATFORM: success = _parseFodPlatform(); break;
-        case Event::SPLIT_MSG:   success = true;               break;
-        case Event::FRAME_START: success = true;               break;
-        case Event::BOOKEND:     success = true;               break;
-
-        default:
-          DOUT1("    Warning: unknown event code " << hex(ev_code) << " encountered; skipping");
-          break;
+        break;
       }
+      success = _parseEvent(ev_code);
       if (not success) {
+        _closeFrameWriter();
         return false;
       }
       if (_payload_sizes[ev_code] == 0) {
         WARN_CORRUPT("    Uninitialized event " << hex(ev_code) << " encountered");
         ++_replay.errors;
-        return true;
+        break;
+      }
+      if (not _index_frames) {
+        _emitFinalized(ev_code);  //Indexed frames aren't decoded until the end
       }
       _length_raw    -= shift;
       _bp            += shift;
       DOUT2("    Raw bytes remaining: " << +_length_raw);
     }
 
+    if (_index_frames) {
+      _decodeFrameEvents();
+      if (_game_end_found) {
+        _computeWinner();  //Deferred until the last frame was actually decoded
+      }
+      _index_frames = false;
+    }
+
+    _emitFrames(_replay.last_frame);
+    _closeFrameWriter();
     return true;
   }
 
+  void Parser::_closeFrameWriter() {
+    if (not _frame_writer.isOpen()) {
+      return;
+    }
+    arrow::Status status = _frame_writer.close(_replay);
+    if (!status.ok()) {
+      WARN("  Error writing player frames to Parquet: " << status.ToString());
+    }
+    _frames_written = true;
+    DOUT1("  Wrote " << _frame_writer.written() << " frames in " << _frame_writer.rowGroups() << " row groups while parsing");
+  }
+
+  void Parser::_scanFrames() {
+    DOUT1("  Scanning events for frame counts");
+
+    //Every frame needs at least one pre-frame event, which bounds what a corrupt frame number can make us allocate
+    int32_t bound     = LOAD_FRAME+int32_t(_length_raw/_payload_sizes[Event::PRE_FRAME]);
+
+    //Walk the event stream using only the payload sizes; anything malformed
+    //  just ends the scan, since the main pass reports it properly
+    int32_t max_fnum  = LOAD_FRAME;
+    uint8_t followers = 0;
+    int32_t last_f    = -1;  //Frame index of the last frame start event
+    _final_segment.clear();
+    for(uint32_t bp = _bp, remaining = _length_raw; remaining > 0; ) {
+      unsigned ev_code = uint8_t(_rb[bp]);
+      unsigned shift   = _payload_sizes[ev_code];
+      if (shift == 0 || shift > remaining) {
+        break;
+      }
+      switch(ev_code) {
+        case Event::PRE_FRAME:
+        case Event::POST_FRAME:
+          if (uint8_t(_rb[bp+O_FOLLOWER]) == 1 && uint8_t(_rb[bp+O_PLAYER]) < 4) {
+            followers |= 1 << uint8_t(_rb[bp+O_PLAYER]);
+          }
+          //Fall through
+        case Event::ITEM_UPDATE:
+        case Event::FOD_PLATFORM:
+          max_fnum = std::max(max_fnum,readBE4S(&_rb[bp+O_FRAME]));
+          break;
+        case Event::FRAME_START: {
+          //The last copy of a frame in the file is the one that was finalized;
+          //  starting a frame at or before the previous one means the game rolled back
+          int32_t f = readBE4S(&_rb[bp+O_FRAME])-LOAD_FRAME;
+          if (f < 0 || f > bound-LOAD_FRAME) {
+            break;  //Corrupt; the main pass will complain about the frame's other events
+          }
+          if (f <= last_f) {
+            _replay.rollbacks       += 1;
+            _replay.rollback_longest = std::max(_replay.rollback_longest,uint32_t(last_f-f+1));
+          }
+          if (unsigned(f) >= _final_segment.size()) {
+            _final_segment.resize(f+1,0);
+          } else if (_final_segment[f] != 0) {
+            _replay.rollback_frames += 1;
+          }
+          _final_segment[f] = bp;
+          last_f            = f;
+          break;
+        }
+        default:
+          break;
+      }
+      bp        += shift;
+      remaining -= shift;
+    }
+
+    _scan_max_frames = std::min(max_fnum,bound)+1;
+    _scan_followers  = followers;
+    DOUT1("    Found " << (_scan_max_frames-LOAD_FRAME) << " frames");
+    if (_replay.rollbacks > 0) {
+      DOUT1("    Found " << _replay.rollbacks << " rollbacks re-simulating " << _replay.rollback_frames
+        << " frames (longest " << _replay.rollback_longest << ")");
+    }
+  }
+
+  bool Parser::_parseSummary() {
+    DOUT1("  Parsing summary");
+
+    //We need the raw length to jump straight to the game end event and the metadata
+    uint32_t raw_end = N_HEADER_BYTES+_length_raw_start;
+    unsigned ge_size = _payload_sizes[Event::GAME_END];
+    if (_length_raw_start == 0 || raw_end > _file_size || raw_end < _bp+ge_size) {
+      DOUT1("    Raw length unusable; parsing all events");
+      return false;
+    }
+    uint32_t ge = raw_end-ge_size;
+    if (uint8_t(_rb[_bp]) != Event::GAME_START || uint8_t(_rb[ge]) != Event::GAME_END) {
+      DOUT1("    Game start / end not where expected; parsing all events");
+      return false;
+    }
+
+    //Events can't be delimited walking backwards, so step back from a known event boundary
+    //  only onto events whose size ends exactly at that boundary and whose frame number
+    //  matches the last frame; anything else (e.g., an unknown event) falls back to a full parse
+    uint32_t synced = ge;
+    int32_t  fnum   = 0;
+    unsigned bookend_size = _payload_sizes[Event::BOOKEND];
+    if (bookend_size > 0 && ge >= _bp+bookend_size && uint8_t(_rb[ge-bookend_size]) == Event::BOOKEND) {
+      synced = ge-bookend_size;
+      fnum   = readBE4S(&_rb[synced+O_BOOKEND_FRAME]);
+    } else if (uint8_t(_rb[ge-_payload_sizes[Event::POST_FRAME]]) == Event::POST_FRAME) {
+      fnum   = readBE4S(&_rb[ge-_payload_sizes[Event::POST_FRAME]+O_FRAME]);
+    } else {
+      DOUT1("    Could not find the last frame; parsing all events");
+      return false;
+    }
+
+    const unsigned frame_events[] = {
+      Event::POST_FRAME, Event::PRE_FRAME, Event::ITEM_UPDATE, Event::FOD_PLATFORM, Event::FRAME_START };
+    uint32_t post[4] = {0};
+    unsigned needed  = 0;
+    for(unsigned p = 0; p < 4; ++p) {
+      if (uint8_t(_rb[_bp+O_PLAYERDATA+0x24*p+O_PLAYER_TYPE]) != 3) {
+        ++needed;
+      }
+    }
+    for(unsigned found = 0; found < needed; ) {
+      unsigned ev_code = 0;
+      for(unsigned code : frame_events) {
+        unsigned shift = _payload_sizes[code];
+        if (shift > 0 && synced >= _bp+shift && uint8_t(_rb[synced-shift]) == code
+            && readBE4S(&_rb[synced-shift+O_FRAME]) == fnum) {
+          ev_code = code;
+          synced -= shift;
+          break;
+        }
+      }
+      if (ev_code == 0 || ev_code == Event::FRAME_START) {
+        break;  //Can't step back any further, or we've reached the start of the last frame
+      }
+      uint8_t p = uint8_t(_rb[synced+O_PLAYER]);
+      if (ev_code == Event::POST_FRAME && _rb[synced+O_FOLLOWER] == 0 && p < 4 && post[p] == 0) {
+        post[p] = synced;
+        ++found;
+      }
+    }
+    for(unsigned p = 0; p < 4; ++p) {
+      if (uint8_t(_rb[_bp+O_PLAYERDATA+0x24*p+O_PLAYER_TYPE]) != 3 && post[p] == 0) {
+        DOUT1("    No last post-frame found for port " << (p+1) << "; parsing all events");
+        return false;
+      }
+    }
+
+    _summarized = true;
+    if (not _parseGameStart()) {
+      return false;
+    }
+    _replay.last_frame  = fnum;
+    _replay.frame_count = fnum-LOAD_FRAME+1;
+    for(unsigned p = 0; p < 4; ++p) {
+      if (post[p] > 0) {
+        _summary_last[p].allocate(1,&_arena);
+        _decoders.post(&_rb[post[p]],_summary_last[p],0);
+      }
+    }
+    _bp = ge;
+    if (not _parseGameEnd()) {
+      return false;
+    }
+    _bp         = raw_end;
+    _length_raw = 0;
+    return true;
+  }
+
+  bool Parser::_parseEvent(unsigned ev_code) {
+    switch(ev_code) { //Determine the event code
+      case Event::GAME_START:   return _parseGameStart();
+      case Event::PRE_FRAME:    return _parsePreFrame();
+      case Event::POST_FRAME:   return _parsePostFrame();
+      case Event::GAME_END:     return _parseGameEnd();
+      case Event::ITEM_UPDATE:  return _parseItemUpdate();
+      case Event::FOD_PLATFORM: return _parseFodPlatform();
+      case Event::SPLIT_MSG:    return true;
+      case Event::FRAME_START:  return _parseFrameStart();
+      case Event::BOOKEND:      return true;
+
+      default:
+        DOUT1("    Warning: unknown event code " << hex(ev_code) << " encountered; skipping");
+        return true;
+    }
+  }
+
   bool Parser::_parseGameStart() {
     DOUT1("  Parsing game start event at byte " << +_bp);
 
@@ -215,6 +766,9 @@ namespace slip {
     _slippi_version = ss.str();
     DOUT1("    Slippi Version: " << _slippi_version);
 
+    //The version can't change from here on, so pick the matching decoders once
+    _decoders = FRAME_DECODERS[schemaTier(_slippi_maj,_slippi_min,_slippi_rev)];
+
     //Get player info
     for(unsigned p = 0; p < 4; ++p) {
       unsigned i                     = O_PLAYERDATA + 0x24*p; //Beginning of player info block
@@ -341,277 +895,207 @@ namespace slip {
       _replay.tiebreaker_number= readBE4U(&_rb[_bp+O_TIEBREAKER_NUMBER]);
     }
 
+    if (_summarized) {
+      return true;  //No frame storage needed
+    }
+
     _max_frames = getMaxNumFrames();
-    _replay.setFrames(_max_frames);
-    DOUT1("    Estimated " << _max_frames << " gameplay frames (" << (_replay.frame_count) << " total frames)");
-    
-    // Initialize platform frames for Fountain of Dreams (stage = 2)
-    if (_replay.stage == 2) {
-      _initializePlatformFrames();
+    uint8_t followers = 0x0F;
+    if (_streaming) {  //Raw length is usually unknown mid-recording, so start small and grow as needed
+      _max_frames = std::max(_max_frames,LOAD_FRAME+STREAM_INITIAL_FRAMES);
+    } else if (_exact_sizing) {
+      unsigned ports = 0, est_ports = 0;
+      for(unsigned p = 0; p < 4; ++p) {
+        if (_replay.player[p].player_type != 3) {
+          bool climber = (_replay.player[p].ext_char_id == CharExt::CLIMBER);
+          est_ports   += climber ? 2 : 1;
+          ports       += (climber && (_scan_followers & (1 << p))) ? 2 : 1;
+        }
+      }
+      DOUT1("    Exact sizing: " << (_scan_max_frames-LOAD_FRAME) << " frames x " << ports << " ports ("
+        << (ports*FrameColumns::bytesFor(_scan_max_frames-LOAD_FRAME) >> 10) << " KiB) instead of "
+        << (_max_frames-LOAD_FRAME) << " frames x " << est_ports << " ports ("
+        << (est_ports*FrameColumns::bytesFor(std::max(_max_frames-LOAD_FRAME,0)) >> 10) << " KiB)");
+      _max_frames = _scan_max_frames;
+      followers   = _scan_followers;
     }
-    
+    _replay.setFrames(_max_frames,followers);
+    DOUT1("    Estimated " << _max_frames << " gameplay frames (" << (_replay.frame_count) << " total frames)");
     return true;
   }
 
-  bool Parser::_parsePreFrame() {
-    DOUT2("  Parsing pre frame event at byte " << +_bp);
-    int32_t fnum = readBE4S(&_rb[_bp+O_FRAME]);
-    int32_t f    = fnum-LOAD_FRAME;
-
-    if (fnum < LOAD_FRAME) {
-      FAIL_CORRUPT("    Frame index " << fnum << " less than " << +LOAD_FRAME);
-      return false;
-    }
-    if (fnum >= _max_frames) {
-      FAIL_CORRUPT("    Frame index " << fnum
-        << " greater than max frames computed from reported raw size (" << _max_frames << ")");
-      return false;
-    }
-
-    uint8_t p    = uint8_t(_rb[_bp+O_PLAYER])+4*uint8_t(_rb[_bp+O_FOLLOWER]); //Includes follower
-    if (p > 7 || _replay.player[p].frame == nullptr) {
-      FAIL_CORRUPT("    Invalid player index " << +p);
-      return false;
-    }
-
-    _replay.last_frame                      = fnum;
-    _replay.frame_count                     = f+1; //Update the last frame we actually read
-    _replay.player[p].frame[f].frame        = fnum;
-    _replay.player[p].frame[f].player       = p%4;
-    _replay.player[p].frame[f].follower     = (p>3);
-    _replay.player[p].frame[f].alive        = 1;
-    _replay.player[p].frame[f].seed         = readBE4U(&_rb[_bp+O_RNG_PRE]);
-    _replay.player[p].frame[f].action_pre   = readBE2U(&_rb[_bp+O_ACTION_PRE]);
-    _replay.player[p].frame[f].pos_x_pre    = readBE4F(&_rb[_bp+O_XPOS_PRE]);
-    _replay.player[p].frame[f].pos_y_pre    = readBE4F(&_rb[_bp+O_YPOS_PRE]);
-    _replay.player[p].frame[f].face_dir_pre = readBE4F(&_rb[_bp+O_FACING_PRE]);
-    _replay.player[p].frame[f].joy_x        = readBE4F(&_rb[_bp+O_JOY_X]);
-    _replay.player[p].frame[f].joy_y        = readBE4F(&_rb[_bp+O_JOY_Y]);
-    _replay.player[p].frame[f].c_x          = readBE4F(&_rb[_bp+O_CX]);
-    _replay.player[p].frame[f].c_y          = readBE4F(&_rb[_bp+O_CY]);
-    _replay.player[p].frame[f].trigger      = readBE4F(&_rb[_bp+O_TRIGGER]);
-    _replay.player[p].frame[f].buttons      = readBE2U(&_rb[_bp+O_BUTTONS]);
-    _replay.player[p].frame[f].phys_l       = readBE4F(&_rb[_bp+O_PHYS_L]);
-    _replay.player[p].frame[f].phys_r       = readBE4F(&_rb[_bp+O_PHYS_R]);
-
-    if(MIN_VERSION(1,2,0)) {
-      _replay.player[p].frame[f].ucf_x        = uint8_t(_rb[_bp+O_UCF_ANALOG]);
+  bool Parser::_parseFrameStart() {
+    if (_final_segment.empty()) {
+      return true;  //No frame map (streaming, or no frame start events in the scan)
     }
-
-    if(MIN_VERSION(1,4,0)) {
-      _replay.player[p].frame[f].percent_pre  = readBE4F(&_rb[_bp+O_DAMAGE_PRE]);
+    int32_t f   = readBE4S(&_rb[_bp+O_FRAME])-LOAD_FRAME;
+    _superseded = (f >= 0 && unsigned(f) < _final_segment.size() && _final_segment[f] != _bp);
+    if (_superseded) {
+      DOUT2("    Skipping rolled back copy of frame " << (f+LOAD_FRAME));
     }
-
     return true;
   }
 
+  bool Parser::_parsePreFrame() {
+    DOUT2("  Parsing pre frame event at byte " << +_bp);
+    return _parseFrameEvent();
+  }
+
   bool Parser::_parsePostFrame() {
     DOUT2("  Parsing post frame event at byte " << +_bp);
+    return _parseFrameEvent();
+  }
+
+  bool Parser::_parseFrameEvent() {
+    if (_superseded) {
+      return true;  //A later copy of this frame overwrites it anyway
+    }
     int32_t fnum = readBE4S(&_rb[_bp+O_FRAME]);
     int32_t f    = fnum-LOAD_FRAME;
 
-    if (fnum < LOAD_FRAME) {
-      FAIL_CORRUPT("    Frame index " << fnum << " less than " << +LOAD_FRAME);
-      return false;
-    }
-    if (fnum >= _max_frames) {
-      FAIL_CORRUPT("    Frame index " << fnum << " greater than max frames computed from reported raw size ("
-        << _max_frames << ")");
+    if (not _frameInRange(fnum)) {
       return false;
     }
 
     uint8_t p    = uint8_t(_rb[_bp+O_PLAYER])+4*uint8_t(_rb[_bp+O_FOLLOWER]); //Includes follower
-    if (p > 7 || _replay.player[p].frame == nullptr) {
+    if (p > 7 || _replay.player[p].cols.empty()) {
       FAIL_CORRUPT("    Invalid player index " << +p);
       return false;
     }
 
-    _replay.player[p].frame[f].char_id       = uint8_t(_rb[_bp+O_INT_CHAR_ID]);
-    if (_replay.player[p].frame[f].char_id >= CharInt::__LAST) {
-      WARN_CORRUPT("    Internal character ID " << +_replay.player[p].frame[f].char_id << " is invalid");
-      ++_replay.errors;
+    if (uint8_t(_rb[_bp]) == Event::PRE_FRAME) {
+      _replay.last_frame  = fnum;
+      _replay.frame_count = f+1; //Update the last frame we actually read
     }
-
-    _replay.player[p].frame[f].action_post   = readBE2U(&_rb[_bp+O_ACTION_POST]);
-    _replay.player[p].frame[f].pos_x_post    = readBE4F(&_rb[_bp+O_XPOS_POST]);
-    _replay.player[p].frame[f].pos_y_post    = readBE4F(&_rb[_bp+O_YPOS_POST]);
-    _replay.player[p].frame[f].face_dir_post = readBE4F(&_rb[_bp+O_FACING_POST]);
-    _replay.player[p].frame[f].percent_post  = readBE4F(&_rb[_bp+O_DAMAGE_POST]);
-    _replay.player[p].frame[f].shield        = readBE4F(&_rb[_bp+O_SHIELD]);
-    _replay.player[p].frame[f].hit_with      = uint8_t(_rb[_bp+O_LAST_HIT_ID]);
-    _replay.player[p].frame[f].combo         = uint8_t(_rb[_bp+O_COMBO]);
-    _replay.player[p].frame[f].hurt_by       = uint8_t(_rb[_bp+O_LAST_HIT_BY]);
-    _replay.player[p].frame[f].stocks        = uint8_t(_rb[_bp+O_STOCKS]);
-
-    if(MIN_VERSION(0,2,0)) {
-      _replay.player[p].frame[f].action_fc     = readBE4F(&_rb[_bp+O_ACTION_FRAMES]);
+    if (_index_frames) {
+      _frame_events.push_back({_bp,f});
+    } else {
+      _replay.errors += _decodeFrameEvent({_bp,f});
     }
+    return true;
+  }
 
-    if(MIN_VERSION(2,0,0)) {
-      _replay.player[p].frame[f].flags_1       = uint8_t(_rb[_bp+O_STATE_BITS_1]);
-      _replay.player[p].frame[f].flags_2       = uint8_t(_rb[_bp+O_STATE_BITS_2]);
-      _replay.player[p].frame[f].flags_3       = uint8_t(_rb[_bp+O_STATE_BITS_3]);
-      _replay.player[p].frame[f].flags_4       = uint8_t(_rb[_bp+O_STATE_BITS_4]);
-      _replay.player[p].frame[f].flags_5       = uint8_t(_rb[_bp+O_STATE_BITS_5]);
-      _replay.player[p].frame[f].hitstun       = readBE4F(&_rb[_bp+O_HITSTUN]);
-      _replay.player[p].frame[f].airborne      = bool(_rb[_bp+O_AIRBORNE]);
-      _replay.player[p].frame[f].ground_id     = readBE2U(&_rb[_bp+O_GROUND_ID]);
-      _replay.player[p].frame[f].jumps         = uint8_t(_rb[_bp+O_JUMPS]);
-      _replay.player[p].frame[f].l_cancel      = uint8_t(_rb[_bp+O_LCANCEL]);
+  unsigned Parser::_decodeFrameEvent(const FrameEvent &e) {
+    char*         ev   = &_rb[e.bp];
+    uint8_t       p    = uint8_t(ev[O_PLAYER])+4*uint8_t(ev[O_FOLLOWER]);
+    FrameColumns& cols = _replay.player[p].cols;
+    if (uint8_t(ev[0]) == Event::PRE_FRAME) {
+      _decoders.pre(ev,cols,e.f);
+      return 0;
     }
-
-    if(MIN_VERSION(2,1,0)) {
-      _replay.player[p].frame[f].hurtbox       = uint8_t(_rb[_bp+O_HURTBOX]);
+    _decoders.post(ev,cols,e.f);
+    if (cols.char_id[e.f] >= CharInt::__LAST) {
+      WARN_CORRUPT("    Internal character ID " << +cols.char_id[e.f] << " is invalid");
+      return 1;
     }
+    return 0;
+  }
 
-    if(MIN_VERSION(3,5,0)) {
-      _replay.player[p].frame[f].self_air_x    = readBE4F(&_rb[_bp+O_SELF_AIR_X]);
-      _replay.player[p].frame[f].self_air_y    = readBE4F(&_rb[_bp+O_SELF_AIR_Y]);
-      _replay.player[p].frame[f].attack_x      = readBE4F(&_rb[_bp+O_ATTACK_X]);
-      _replay.player[p].frame[f].attack_y      = readBE4F(&_rb[_bp+O_ATTACK_Y]);
-      _replay.player[p].frame[f].self_grd_x    = readBE4F(&_rb[_bp+O_SELF_GROUND_X]);
+  void Parser::_decodeFrameEvents() {
+    int32_t nframes = 0;
+    for (const FrameEvent &e : _frame_events) {
+      nframes = std::max(nframes,e.f+1);
     }
-
-    if(MIN_VERSION(3,8,0)) {
-      _replay.player[p].frame[f].hitlag        = readBE4F(&_rb[_bp+O_HITLAG]);
+    unsigned nthreads = std::min<size_t>(_threads,1+_frame_events.size()/MIN_EVENTS_PER_THREAD);
+    DOUT1("  Decoding " << _frame_events.size() << " frame events with " << nthreads << " threads");
+
+    //Each thread owns a contiguous range of frames and decodes that range's events in
+    //  file order, so slots written more than once (e.g., after a rollback) keep the last write.
+    //  Events are bucketed by range first (a stable counting sort), so each thread only
+    //  walks its own events instead of scanning all of them.
+    std::vector<FrameEvent> bucketed;
+    std::vector<size_t>     first(nthreads+1,0);  //Thread t decodes bucketed[first[t],first[t+1])
+    if (nthreads > 1) {
+      //Ranges are whole bytes of the flag bit arrays (8 frames), so no two threads share a byte
+      int32_t blocks = (nframes+7)/8;
+      auto range = [blocks,nthreads](int32_t f) { return unsigned(int64_t(f/8)*nthreads/blocks); };
+      for (const FrameEvent &e : _frame_events) {
+        ++first[range(e.f)+1];
+      }
+      for (unsigned t = 0; t < nthreads; ++t) {
+        first[t+1] += first[t];
+      }
+      std::vector<size_t> next(first.begin(),first.end()-1);
+      bucketed.resize(_frame_events.size());
+      for (const FrameEvent &e : _frame_events) {
+        bucketed[next[range(e.f)]++] = e;
+      }
+    } else {
+      bucketed.swap(_frame_events);
+      first[1] = bucketed.size();
     }
 
-    if(MIN_VERSION(3,11,0)) {
-      _replay.player[p].frame[f].anim_index    = readBE4U(&_rb[_bp+O_ANIM_INDEX]);
+    std::vector<unsigned> errors(nthreads,0);
+    auto decodeRange = [this,&bucketed,&first,&errors](unsigned t) {
+      for (size_t i = first[t]; i < first[t+1]; ++i) {
+        errors[t] += _decodeFrameEvent(bucketed[i]);
+      }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < nthreads; ++t) {
+      pool.emplace_back(decodeRange,t);
+    }
+    decodeRange(0);
+    for (std::thread &t : pool) {
+      t.join();
+    }
+    for (unsigned e : errors) {
+      _replay.errors += e;
     }
 
-    return true;
+    _frame_events.clear();
+    _frame_events.shrink_to_fit();
   }
 
   bool Parser::_parseItemUpdate() {
     DOUT2("  Parsing item frame event at byte " << +_bp);
+    if (_superseded) {
+      return true;  //Only keep the final copy of each item frame
+    }
     int32_t fnum = readBE4S(&_rb[_bp+O_FRAME]);
     int32_t relativeFrame    = fnum - LOAD_FRAME;
 
-    if (fnum < LOAD_FRAME) {
-      FAIL_CORRUPT("    Frame index " << fnum << " less than " << +LOAD_FRAME);
-      return false;
-    }
-    if (fnum >= _max_frames) {
-      FAIL_CORRUPT("    Frame index " << fnum << " greater than max frames computed from reported raw size ("
-        << _max_frames << ")");
+    if (not _frameInRange(fnum)) {
       return false;
     }
 
     uint32_t id    = readBE4U(&_rb[_bp+O_ITEM_ID]);
-
-    if (id >= MAX_ITEMS) {
-      return true;  //We can't output this many items (TODO: what's with item ID 3039053192???)
-    }
-
-    int32_t f = _replay.item[id].num_frames;
-    _replay.item[id].spawn_id = id;
-    if (_replay.item[id].frame == nullptr) {
-      _replay.item[id].frame = new SlippiItemFrame[MAX_ITEM_LIFE];
-    }
-    if (id >= _replay.num_items) {
-      _replay.num_items = id + 1;
-    }
-
-    if (f < MAX_ITEM_LIFE) {
-      _replay.item[id].num_frames       += 1;
-      _replay.item[id].type              = readBE2U(&_rb[_bp+O_ITEM_TYPE]);
-      _replay.item[id].frame[f].frame    = fnum;
-      _replay.item[id].frame[f].state    = uint8_t(_rb[_bp+O_ITEM_STATE]);
-      _replay.item[id].frame[f].face_dir = readBE4F(&_rb[_bp+O_ITEM_FACING]);
-      _replay.item[id].frame[f].xvel     = readBE4F(&_rb[_bp+O_ITEM_XVEL]);
-      _replay.item[id].frame[f].yvel     = readBE4F(&_rb[_bp+O_ITEM_YVEL]);
-      _replay.item[id].frame[f].xpos     = readBE4F(&_rb[_bp+O_ITEM_XPOS]);
-      _replay.item[id].frame[f].ypos     = readBE4F(&_rb[_bp+O_ITEM_YPOS]);
-      _replay.item[id].frame[f].damage   = readBE2U(&_rb[_bp+O_ITEM_DAMAGE]);
-      _replay.item[id].frame[f].expire   = readBE4F(&_rb[_bp+O_ITEM_EXPIRE]);
-      if(MIN_VERSION(3,2,0)) {
-        _replay.item[id].frame[f].flags_1  = uint8_t(_rb[_bp+O_ITEM_MISC]);
-        _replay.item[id].frame[f].flags_2  = uint8_t(_rb[_bp+O_ITEM_MISC+1]);
-        _replay.item[id].frame[f].flags_3  = uint8_t(_rb[_bp+O_ITEM_MISC+2]);
-        _replay.item[id].frame[f].flags_4  = uint8_t(_rb[_bp+O_ITEM_MISC+3]);
-      }
-      if(MIN_VERSION(3,6,0)) {
-        _replay.item[id].frame[f].owner    = int8_t(_rb[_bp+O_ITEM_OWNER]);
-      }
-      
-    } else {
-      DOUT2("    Item " << +id << " was alive longer than expected ");
+    int32_t  index = _replay.item_index.find(id);
+    if (index < 0) {
+      index = _replay.items.size();
+      _replay.items.emplace_back();
+      _replay.items.back().spawn_id = id;
+      _replay.item_index.insert(id,index);
+      _replay.num_items = _replay.items.size();
     }
 
+    SlippiItem& item = _replay.items[index];
+    item.type        = readBE2U(&_rb[_bp+O_ITEM_TYPE]);
+    _decoders.item(&_rb[_bp],item.append(&_arena));
+
     return true;
   }
 
   bool Parser::_parseFodPlatform() {
-    if (_replay.stage == 2) {
+    if (_replay.stage == 2 && !_superseded) {
       DOUT2("  Parsing FoD platform event at byte " << +_bp);
       int32_t fnum = readBE4S(&_rb[_bp+O_FRAME]);
       int32_t f    = fnum - LOAD_FRAME;
 
-      if (fnum < LOAD_FRAME) {
-        FAIL_CORRUPT("    Frame index " << fnum << " less than " << +LOAD_FRAME);
-        return false;
-      }
-      if (fnum >= _max_frames) {
-        FAIL_CORRUPT("    Frame index " << fnum << " greater than max frames computed from reported raw size ("
-          << _max_frames << ")");
+      if (not _frameInRange(fnum)) {
         return false;
       }
 
       uint8_t platform = _rb[_bp+O_PLATFORM];
       float platform_height = readBE4F(&_rb[_bp+O_PLAT_HEIGHT]);
 
-      // Update platform frames data for Fountain of Dreams (stage = 2)
-        _updatePlatformFrames(f, platform, platform_height);
+      //Only the change is stored; heights are filled in per frame when written out
+      _replay.setPlatformHeight(f, platform, platform_height);
     }
 
     return true;
   }
 
-  void Parser::_updatePlatformFrames(int32_t frame, uint8_t platform, float height) {
-    // Find or create the platform frame entry for this frame
-    SlippiFodPlatformFrame* frame_data = nullptr;
-    
-    // Look for existing frame data
-    for (auto& pf : _replay.platform_frames) {
-      if (pf.frame == frame) {
-        frame_data = &pf;
-        break;
-      }
-    }
-    
-    // If not found, create new frame data
-    if (!frame_data) {
-      SlippiFodPlatformFrame new_frame = { frame, 20.0f, 27.44186047f }; // Default heights from constants.ts
-      _replay.platform_frames.push_back(new_frame);
-      frame_data = &_replay.platform_frames.back();
-    }
-    
-    // Update the appropriate platform height for this frame and all subsequent frames
-    if (platform == 0) { // Right platform
-      for (auto& pf : _replay.platform_frames) {
-        if (pf.frame >= frame) {
-          pf.right_height = height;
-        }
-      }
-    } else if (platform == 1) { // Left platform
-      for (auto& pf : _replay.platform_frames) {
-        if (pf.frame >= frame) {
-          pf.left_height = height;
-        }
-      }
-    }
-  }
-
-  void Parser::_initializePlatformFrames() {
-    // Initialize platform frames for every frame with default heights
-    // Use _max_frames to initialize all possible frames that could exist in the replay
-    for (int32_t frame = 0; frame < _max_frames; ++frame) {
-      SlippiFodPlatformFrame frame_data = { frame, 20.0f, 27.44186047f }; // Default heights from constants.ts
-      _replay.platform_frames.push_back(frame_data);
-    }
-  }
-
   bool Parser::_parseGameEnd() {
     DOUT1("  Parsing game end event at byte " << +_bp);
     _game_end_found          = true;
@@ -621,6 +1105,13 @@ namespace slip {
       _replay.lras           = int8_t(_rb[_bp+O_LRAS]);
     }
 
+    if (not _index_frames) {
+      _computeWinner();
+    }
+    return true;
+  }
+
+  void Parser::_computeWinner() {
     // Determine game winner
     // TODO: should account for LRAS
     int   winner_stocks = 0;
@@ -629,16 +1120,19 @@ namespace slip {
       if (_replay.player[p].player_type == 3) {
         continue;  //If we're not playing, we probably didn't win
       }
-      int   end_stocks = _replay.player[p].frame[_replay.frame_count-1].stocks;
+      int   end_stocks = _lastFrame(p).stocks;
       _replay.player[p].end_stocks = end_stocks;
-      float end_damage = _replay.player[p].frame[_replay.frame_count-1].percent_post;
+      float end_damage = _lastFrame(p).percent_post;
       if ((end_stocks > winner_stocks) || (end_stocks == winner_stocks && end_damage < winner_damage)) {
         winner_stocks = end_stocks;
         winner_damage = end_damage;
         _replay.winner_id = p;  //Tentatively set this person as the winner
       }
     }
-    return true;
+  }
+
+  SlippiFrame Parser::_lastFrame(unsigned p) {
+    return _summarized ? _summary_last[p].row(0) : _replay.player[p].cols.row(_replay.frame_count-1);
   }
 
   bool Parser::_parseMetadata() {
@@ -790,30 +1284,90 @@ namespace slip {
   }
 
   Analysis* Parser::analyze() {
+    if (_summarized) {
+      FAIL("  Replay was loaded without frame data; can't analyze it");
+      Analysis* a = new Analysis(0);
+      a->success  = false;
+      return a;
+    }
     Analyzer a(_debug);
     return a.analyze(_replay);
   }
 
+  bool Parser::analyze(Analysis &a) {
+    if (_summarized) {
+      FAIL("  Replay was loaded without frame data; can't analyze it");
+      a.reset(0);
+      return false;
+    }
+    Analyzer analyzer(_debug);
+    return analyzer.analyze(_replay,&a);
+  }
+
   void Parser::_cleanup() {
     _replay.cleanup();
+    for(unsigned p = 0; p < 4; ++p) {
+      _summary_last[p].release();
+    }
+  }
+
+  void Parser::_resetReplay() {
+    _cleanup();
+    _arena.reset();
+
+    //Start from a blank replay, but hang on to the capacity of its containers
+    std::vector<SlippiFodPlatformFrame> platform_changes;
+    std::vector<SlippiItem>             items;
+    SlippiItemIndex                     item_index;
+    platform_changes.swap(_replay.platform_changes);
+    items.swap(_replay.items);
+    std::swap(item_index,_replay.item_index);
+    platform_changes.clear();
+    _replay = SlippiReplay();
+    _replay.platform_changes.swap(platform_changes);
+    _replay.items.swap(items);
+    std::swap(_replay.item_index,item_index);
+    _replay.arena = &_arena;
+
+    memset(_payload_sizes, 0, sizeof(_payload_sizes));
+    _slippi_maj      = 0;
+    _slippi_min      = 0;
+    _slippi_rev      = 0;
+    _max_frames      = 0;
+    _decoders        = FRAME_DECODERS[TIER_0_1];
+    _game_end_found  = false;
+    _scan_max_frames = 0;
+    _scan_followers  = 0;
+    _superseded      = false;
+    _summarized      = false;
+    _index_frames    = false;
+    _streaming       = false;
+    _stream_emitted  = 0;
+    _frames_written  = false;
+    _final_segment.clear();
+    _frame_events.clear();
   }
 
-  void Parser::playerFramesAsParquet() {
-    arrow::Status status = _replay.playerFramesAsParquet();
+  void Parser::playerFramesAsParquet(const OutputSink& sink) {
+    if (_frames_written) {
+      DOUT1("  Player frames were already written to the stream sink while parsing");
+      return;
+    }
+    arrow::Status status = _batch ? _replay.playerFramesAsParquet(_batch->frames) : _replay.playerFramesAsParquet(sink,_parquet);
     if (!status.ok()) {
       std::cerr << "Error writing player frames to Parquet: " << status.ToString() << std::endl;
     }
   }
 
-  void Parser::itemFramesAsParquet() {
-    arrow::Status status = _replay.itemFramesAsParquet();
+  void Parser::itemFramesAsParquet(const OutputSink& sink) {
+    arrow::Status status = _batch ? _replay.itemFramesAsParquet(_batch->items) : _replay.itemFramesAsParquet(sink,_parquet);
     if (!status.ok()) {
       std::cerr << "Error writing item frames to Parquet: " << status.ToString() << std::endl;
     }
   }
 
-  void Parser::fodPlatformFramesAsParquet() {
-    arrow::Status status = _replay.fodPlatformFramesAsParquet();
+  void Parser::fodPlatformFramesAsParquet(const OutputSink& sink) {
+    arrow::Status status = _batch ? _replay.fodPlatformFramesAsParquet(_batch->platforms) : _replay.fodPlatformFramesAsParquet(sink,_parquet);
     if (!status.ok()) {
       std::cerr << "Error writing FOD platform frames to Parquet: " << status.ToString() << std::endl;
     }
@@ -831,35 +1385,27 @@ namespace slip {
     return _replay.matchSettingsAsJson(filename);
   }
 
-  void Parser::save(const char* outfilename, const char* infilename, bool delta) {
-
-    DOUT1("  Saving Settings");
-    std::string settingsFileName = std::string(outfilename) + "/settings.json";
-    std::ofstream ofile1;
-    ofile1.open(settingsFileName.c_str());
-    ofile1 << settingsAsJson() << std::endl;
-    ofile1.close();
-    DOUT1("  Saved to " << settingsFileName);
-
-    DOUT1("  Saving Match Settings");
-    std::string matchSettingsFileName = std::string(outfilename) + "/match-settings.jsonl";
-    std::ofstream ofile2;
-    ofile2.open(matchSettingsFileName.c_str());
-    ofile2 << matchSettingsAsJson(std::string(infilename)) << std::endl;
-    ofile2.close();
-    DOUT1("  Saved to " << matchSettingsFileName);
-
-    DOUT1("  Saving Player Settings");
-    std::string playerSettingsFileName = std::string(outfilename) + "/player-settings.jsonl";
-    std::ofstream ofile3;
-    ofile3.open(playerSettingsFileName.c_str());
-    ofile3 << playerSettingsAsJson() << std::endl;
-    ofile3.close();
-    DOUT1("  Saved to " << playerSettingsFileName);
-
-    playerFramesAsParquet();
-    itemFramesAsParquet();
-    fodPlatformFramesAsParquet();
+  void Parser::save(const OutputSink& sink, const char* infilename, bool delta) {
+    const std::pair<const char*,std::string> json[] = {
+      { "settings.json",         settingsAsJson() },
+      { "match-settings.jsonl",  matchSettingsAsJson(std::string(infilename)) },
+      { "player-settings.jsonl", playerSettingsAsJson() },
+    };
+    for (const auto& file : json) {
+      DOUT1("  Saving " << file.first);
+      arrow::Status status = sink.writeText(file.first, file.second + "\n");
+      if (!status.ok()) {
+        std::cerr << "Error writing " << file.first << ": " << status.ToString() << std::endl;
+      }
+    }
+
+    if (_summarized) {
+      DOUT1("  Replay was loaded without frame data; skipping frame output");
+      return;
+    }
+    playerFramesAsParquet(sink);
+    itemFramesAsParquet(sink);
+    fodPlatformFramesAsParquet(sink);
 
   }
 
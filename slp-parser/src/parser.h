@@ -5,19 +5,36 @@
 #include <fstream>
 #include <sstream>
 #include <regex>
+#include <vector>
+#include <functional>
+#include <thread>
 
 #include "util.h"
 #include "replay.h"
 #include "analyzer.h"
 #include "schema.h"
+#include "decoders.h"
 
 // Replay File (.slp) Spec: https://github.com/project-slippi/slippi-wiki/blob/master/SPEC.md
 
 namespace slip {
 
+const int32_t STREAM_INITIAL_FRAMES = 3600; //Frames to allocate up front when streaming (one minute of gameplay)
+const uint32_t MIN_EVENTS_PER_THREAD = 4096; //Don't bother spinning up a decode thread for fewer frame events than this
+
+//Location of a pre / post frame event whose decoding has been deferred to the parallel pass
+struct FrameEvent {
+  uint32_t bp;  //Offset of the event in the read buffer
+  int32_t  f;   //Frame index (fnum - LOAD_FRAME) the event writes to
+};
+
+//Called with the replay and the index of each frame once it can no longer change
+typedef std::function<void(const SlippiReplay&, uint32_t)> FrameCallback;
+
 class Parser {
 private:
   int             _debug;                    //Current debug level
+  Arena           _arena;                    //Frame storage for the current replay, recycled between replays
   SlippiReplay    _replay;                   //Internal struct for replay being parsed
   uint16_t        _payload_sizes[256] = {0}; //Size of payload for each event
   std::string     _slippi_version;           //String representation of the Slippi version of the replay
@@ -25,47 +42,120 @@ private:
   uint8_t         _slippi_min     = 0;       //Minor version number of replay being parsed
   uint8_t         _slippi_rev     = 0;       //Revision number of replay being parsed
   int32_t         _max_frames     = 0;       //Maximum number of frames that there will be in the replay file
+  FrameDecoders   _decoders = FRAME_DECODERS[TIER_0_1]; //Frame / item decoders for this replay's version
   bool            _game_end_found = false;   //Whether we've found the game end event
-
+  bool            _exact_sizing   = true;    //Whether to size frame storage from a scan of the events
+  int32_t         _scan_max_frames = 0;      //One past the last frame number seen by _scanFrames()
+  uint8_t         _scan_followers = 0;       //Bitmask of ports whose followers have frame events
+  std::vector<uint32_t> _final_segment;      //Offset of the frame start event of each frame's final (non-rolled back) copy
+  bool            _superseded     = false;   //Whether the events being parsed belong to a rolled back copy of a frame
+  bool            _summary_only   = false;   //Whether to skip frame data when possible (settings / metadata only)
+  bool            _summarized     = false;   //Whether the replay was loaded without frame data
+  FrameColumns    _summary_last[4];          //Last post-frame of each port (one frame each) when summarized
+  unsigned        _threads        = 1;       //Number of threads to decode frame events with
+  bool            _index_frames   = false;   //Whether frame events are being indexed for parallel decoding
+  std::vector<FrameEvent> _frame_events;     //Indexed pre / post frame events awaiting decoding
+
+  enum StreamState { SS_HEADER, SS_PAYLOADS, SS_EVENTS, SS_METADATA };
+
+  bool              _streaming      = false;     //Whether we're parsing incrementally via feed()
+  StreamState       _stream_state   = SS_HEADER; //Which part of the file the next fed bytes belong to
+  std::vector<char> _sb;                         //Stream buffer holding bytes fed but not yet consumed
+  uint32_t          _stream_emitted = 0;         //Number of frames already passed to _on_frame / _frame_writer
+  FrameCallback     _on_frame       = nullptr;   //Consumer of completed frames while streaming or loading
+  bool              _stream_frames  = false;     //Whether to write player frames while parsing instead of at save()
+  ParquetOptions    _parquet;                    //How Parquet output is written
+  OutputSink        _stream_sink;                //Where player frames written while parsing go
+  ParquetBatch*     _batch          = nullptr;   //Shared Parquet files to append to instead of per-replay ones
+  PlayerFrameWriter _frame_writer;               //Writes player frames to Parquet as they're finalized
+  bool              _frames_written = false;     //Whether the loaded replay's player frames were already written
+
+  enum RbSource { RB_HEAP, RB_MAPPED, RB_BORROWED };
 
   char*           _rb = nullptr; //Read buffer
+  RbSource        _rb_source = RB_HEAP; //Whether _rb is heap memory we own, a file mapping, or caller-owned memory
+  char*           _rb_heap = nullptr; //Heap read buffer, kept between replays
+  uint32_t        _rb_heap_size = 0; //Capacity of _rb_heap in bytes
+  char*           _heapBuffer(uint32_t size); //Point _rb at a heap buffer of at least size bytes
   unsigned        _bp; //Current position in buffer
   uint32_t        _length_raw; //Remaining length of raw payload
   uint32_t        _length_raw_start; //Total length of raw payload
   uint32_t        _file_size; //Total size of the replay file on disk
+  bool            _mapFile(const char* replayfilename); //Memory-map a regular file into _rb
+  bool            _readFile(const char* replayfilename); //Copy a file into a heap-allocated _rb
+  void            _releaseBuffer(); //Unmap / let go of the read buffer (the heap buffer itself is kept)
   bool            _parse(); //Internal main parsing funnction
   bool            _parseHeader();
   bool            _parseEventDescriptions();
   bool            _parseEvents();
+  void            _scanFrames(); //Find the exact frame count, which followers are present, and each frame's final copy
+  bool            _parseSummary(); //Parse game start, the last frame, and game end without touching other events
+  bool            _parseEvent(unsigned ev_code); //Dispatch a single event at _bp
+  bool            _parseStream(); //Consume as many complete events from _sb as possible
+  void            _emitFrames(int32_t last_fnum); //Pass completed frames up to last_fnum to _on_frame / _frame_writer
+  void            _emitFinalized(unsigned ev_code); //Emit whatever frames the event at _bp shows can no longer change
+  void            _closeFrameWriter(); //Finish the player frames written while parsing
+  bool            _frameInRange(int32_t fnum); //Check (and when streaming, grow) frame storage for fnum
+  void            _finish(); //Final checks once all events have been parsed
   bool            _parseGameStart();
+  bool            _parseFrameStart();
   bool            _parsePreFrame();
   bool            _parsePostFrame();
+  bool            _parseFrameEvent(); //Validate a pre / post frame event, then decode it or index it for later
+  unsigned        _decodeFrameEvent(const FrameEvent &e); //Decode a validated frame event; returns errors found
+  void            _decodeFrameEvents(); //Decode all indexed frame events across _threads threads
   bool            _parseGameEnd();
+  void            _computeWinner(); //Determine the winner from the last frame of the game
+  SlippiFrame     _lastFrame(unsigned p); //Port p's frame at the end of the game
   bool            _parseItemUpdate();
   bool            _parseFodPlatform();
-  void            _updatePlatformFrames(int32_t frame, uint8_t platform, float height);
-  void            _initializePlatformFrames();
   bool            _parseMetadata();
   void            _cleanup(); //Cleanup replay data
+  void            _resetReplay(); //Clear the previous replay (keeping its storage) before loading another
 public:
   Parser(int debug_level);               //Instantiate the parser (possibly in debug mode)
   ~Parser();                             //Destroy the parser
+  void setThreads(unsigned threads);     //Decode frames with this many threads (0 = one per core)
+  void setExactSizing(bool exact);       //Size frame storage from a pre-scan (default) or from getMaxNumFrames()
+  void setSummaryOnly(bool summary);     //Only parse what the settings JSON needs, skipping frame data when possible
+  void setFrameCallback(FrameCallback on_frame); //Pass each frame to on_frame as soon as it's final while loading
+  void setFrameStreaming(bool stream);   //Write player frames to Parquet while parsing, a row group at a time, instead of at save()
+  void setStreamSink(const OutputSink& sink); //Where setFrameStreaming() writes player frames (save() is given its own sink)
+  void setParquetOptions(const ParquetOptions& o); //Set how every Parquet file is compressed, encoded, and split up
+  void setParquetBatch(ParquetBatch* batch); //Append Parquet output to files shared with other replays (nullptr = one set per replay)
+  inline bool summarized() const { return _summarized; } //Whether the last load skipped frame data
+  void reset();                          //Drop the loaded replay, keeping buffers sized for the next one
   bool load(const char* replayfilename); //Load a replay file
+  bool loadFromBuffer(const char* buffer, uint32_t length, const char* name = ""); //Parse a replay already in memory (not copied)
+  void beginStream(FrameCallback on_frame = nullptr); //Start parsing a replay that is still being written
+  bool feed(const char* data, uint32_t length);       //Parse the next chunk of a streamed replay
+  bool endStream();                                   //Finish a streamed replay (parses metadata if present)
   Analysis* analyze();                   //Analyze the loaded replay file
-  void playerFramesAsParquet();
-  void itemFramesAsParquet();
-  void fodPlatformFramesAsParquet();
+  bool analyze(Analysis &a);             //Analyze the loaded replay into an existing Analysis, reusing its storage
+  void playerFramesAsParquet(const OutputSink& sink);
+  void itemFramesAsParquet(const OutputSink& sink);
+  void fodPlatformFramesAsParquet(const OutputSink& sink);
   std::string settingsAsJson();
   std::string playerSettingsAsJson();
   std::string matchSettingsAsJson(const std::string& filename);
 
-  void save(const char* outfilename, const char* infilename, bool delta); //Save a replay file
+  void save(const OutputSink& sink, const char* infilename, bool delta); //Save a replay's JSON and Parquet files to the sink (Parquet to the batch, if set)
 
   //Getter function for exposing read-only access to underlying replay
   inline const SlippiReplay* replay() const {
     return &_replay;
   };
 
+  //Getter function for the writer that streams player frames while parsing
+  inline const PlayerFrameWriter* frameWriter() const {
+    return &_frame_writer;
+  };
+
+  //Getter function for the arena backing the replay's frame storage
+  inline const Arena* arena() const {
+    return &_arena;
+  };
+
   //Estimate the maximum number of frames stored in the file
   //  -> Assumes only two people are alive for the whole match / one ice climber
   inline int32_t getMaxNumFrames() {
@@ -8,6 +8,10 @@
 #include <vector>
 #include <memory>
 #include <fstream>
+#include <cstring>
+#include <new>
+#include <algorithm>
+#include <functional>
 
 //JSON Output shortcuts
 #define JFLT(k,n) " \"" << (k) << "\": " << std::fixed << std::setprecision(2) << float(n)
@@ -15,308 +19,488 @@
 #define JUIN(k,n) " " << "\"" << (k) << "\": " << uint32_t(n)
 #define JSTR(k,s) " " << "\"" << (k) << "\": \"" << (s) << "\""
 //Logic for outputting a line only if it changed since last frame (or if we're in full output mode)
-#define CHANGED(field) (not delta) || (f == 0) || (s.player[p].frame[f].field != s.player[p].frame[f-1].field)
-#define ICHANGED(field) (not delta) || (f == 0) || (s.item[i].frame[f].field != s.item[i].frame[f-1].field)
+#define CHANGED(field) (not delta) || (f == 0) || (s->player[p].cols.field[f] != s->player[p].cols.field[f-1])
+#define ICHANGED(field) (not delta) || (f == 0) || (s->items[i].frame(f).field != s->items[i].frame(f-1).field)
 //Logic for outputting a comma or not depending on whether we're the first element in a JSON object
 #define JEND(a) ((a++ == 0) ? "" : ",")
 
 namespace slip {
 
-void SlippiReplay::setFrames(int32_t max_frames) {
+//SLIPPI_FRAME_FIELDS and SLIPPI_FRAME_FLAGS must list every SlippiFrame field, in order
+#define FRAME_FIELD(type,name) type name;
+#define FRAME_FLAG(name) bool name : 1;
+struct _FrameFieldsCheck { SLIPPI_FRAME_FIELDS(FRAME_FIELD) SLIPPI_FRAME_FLAGS(FRAME_FLAG) };
+#undef FRAME_FLAG
+#undef FRAME_FIELD
+static_assert(sizeof(_FrameFieldsCheck) == sizeof(SlippiFrame), "SLIPPI_FRAME_FIELDS is out of sync with SlippiFrame");
+
+//Round a column's size up so the next column starts on its own cache line
+static inline size_t columnBytes(uint32_t n, size_t size) {
+  return (n*size+ARENA_ALIGN-1) & ~(ARENA_ALIGN-1);
+}
+
+size_t FrameColumns::bytesFor(uint32_t n) {
+  size_t bytes = 0;
+#define FRAME_COLUMN(type,name) bytes += columnBytes(n,sizeof(type));
+  SLIPPI_FRAME_FIELDS(FRAME_COLUMN)
+#undef FRAME_COLUMN
+#define FRAME_FLAG(name) bytes += columnBytes((n+7)/8,1);
+  SLIPPI_FRAME_FLAGS(FRAME_FLAG)
+#undef FRAME_FLAG
+  return bytes;
+}
+
+void FrameColumns::allocate(uint32_t n, Arena* from) {
+  release();
+  size_t bytes = bytesFor(n);
+  if (from != nullptr) {
+    block = static_cast<char*>(from->allocate(bytes));
+  } else {
+    block = static_cast<char*>(::operator new[](bytes, std::align_val_t(ARENA_ALIGN)));
+    memset(block, 0, bytes);
+  }
+  arena = from;
+  count = n;
+  char* next = block;
+#define FRAME_COLUMN(type,name) \
+  name = reinterpret_cast<type*>(next); next += columnBytes(n,sizeof(type));
+  SLIPPI_FRAME_FIELDS(FRAME_COLUMN)
+#undef FRAME_COLUMN
+#define FRAME_FLAG(name) \
+  name.bits = reinterpret_cast<uint8_t*>(next); next += columnBytes((n+7)/8,1);
+  SLIPPI_FRAME_FLAGS(FRAME_FLAG)
+#undef FRAME_FLAG
+}
+
+void FrameColumns::resize(uint32_t n) {
+  FrameColumns grown;
+  grown.allocate(n,arena);
+  uint32_t keep = std::min(count,n);
+#define FRAME_COLUMN(type,name) std::copy(name, name+keep, grown.name);
+  SLIPPI_FRAME_FIELDS(FRAME_COLUMN)
+#undef FRAME_COLUMN
+#define FRAME_FLAG(name) std::copy(name.bits, name.bits+(keep+7)/8, grown.name.bits);
+  SLIPPI_FRAME_FLAGS(FRAME_FLAG)
+#undef FRAME_FLAG
+  release();
+  *this = grown;
+}
+
+void FrameColumns::release() {
+  if (block != nullptr && arena == nullptr) {
+    ::operator delete[](block, std::align_val_t(ARENA_ALIGN));
+  }
+  *this = FrameColumns();
+}
+
+SlippiFrame FrameColumns::row(uint32_t f) const {
+  SlippiFrame r = {};
+#define FRAME_COLUMN(type,name) r.name = name[f];
+  SLIPPI_FRAME_FIELDS(FRAME_COLUMN)
+#undef FRAME_COLUMN
+#define FRAME_FLAG(name) r.name = name[f];
+  SLIPPI_FRAME_FLAGS(FRAME_FLAG)
+#undef FRAME_FLAG
+  return r;
+}
+
+SlippiItemFrame& SlippiItem::append(Arena* arena) {
+  if (last == nullptr || last->count == last->capacity) {
+    uint32_t capacity = (last == nullptr) ? ITEM_RUN_MIN_FRAMES : std::min(2*last->capacity,ITEM_RUN_MAX_FRAMES);
+    size_t   bytes    = sizeof(SlippiItemRun)+capacity*sizeof(SlippiItemFrame);
+    void*    block    = arena ? arena->allocate(bytes) : ::operator new(bytes);
+    SlippiItemRun* run = new (block) SlippiItemRun();
+    run->frame    = reinterpret_cast<SlippiItemFrame*>(run+1);
+    run->capacity = capacity;
+    for (uint32_t i = 0; i < capacity; ++i) {
+      new (run->frame+i) SlippiItemFrame();
+    }
+    if (last == nullptr) {
+      first = run;
+    } else {
+      last->next = run;
+    }
+    last = run;
+  }
+  ++num_frames;
+  return last->frame[last->count++];
+}
+
+const SlippiItemFrame& SlippiItem::frame(uint32_t f) const {
+  const SlippiItemRun* run = first;
+  while (f >= run->count) {
+    f  -= run->count;
+    run = run->next;
+  }
+  return run->frame[f];
+}
+
+void SlippiItem::release() {
+  for (SlippiItemRun* run = first; run != nullptr; ) {
+    SlippiItemRun* next = run->next;
+    ::operator delete(run);
+    run = next;
+  }
+  first = last = nullptr;
+  num_frames = 0;
+}
+
+//Fibonacci hashing of spawn IDs (which are mostly sequential) into a power-of-two table
+static inline size_t itemSlot(uint32_t id, size_t mask) {
+  return (uint32_t(id*2654435769u) >> 7) & mask;
+}
+
+int32_t SlippiItemIndex::find(uint32_t id) const {
+  if (slots.empty()) {
+    return -1;
+  }
+  size_t mask = slots.size()-1;
+  for (size_t i = itemSlot(id,mask); slots[i] != 0; i = (i+1) & mask) {
+    if (uint32_t(slots[i] >> 32) == id) {
+      return int32_t(uint32_t(slots[i])-1);
+    }
+  }
+  return -1;
+}
+
+void SlippiItemIndex::insert(uint32_t id, uint32_t index) {
+  if (2*(used+1) > slots.size()) {  //Keep the table at most half full
+    std::vector<uint64_t> old(std::max(size_t(64),2*slots.size()),0);
+    old.swap(slots);
+    used = 0;
+    for (uint64_t e : old) {
+      if (e != 0) {
+        insert(uint32_t(e >> 32),uint32_t(e)-1);
+      }
+    }
+  }
+  size_t mask = slots.size()-1;
+  size_t i    = itemSlot(id,mask);
+  while (slots[i] != 0) {
+    i = (i+1) & mask;
+  }
+  slots[i] = (uint64_t(id) << 32) | (uint64_t(index)+1);
+  ++used;
+}
+
+void SlippiItemIndex::clear() {
+  std::fill(slots.begin(), slots.end(), 0);
+  used = 0;
+}
+
+//Allocate frames for each active port; followers is a bitmask of ports whose follower
+//  (if any) should get frames too
+void SlippiReplay::setFrames(int32_t max_frames, uint8_t followers) {
   this->last_frame  = max_frames;
   this->frame_count = max_frames-this->first_frame;
   for(unsigned i = 0; i < 4; ++i) {
     if (this->player[i].player_type != 3) {
-      this->player[i].frame = new SlippiFrame[this->frame_count];
-      if (this->player[i].ext_char_id == CharExt::CLIMBER) { //Extra player for Ice Climbers
-        this->player[i+4].frame = new SlippiFrame[this->frame_count];
+      this->player[i].cols.allocate(this->frame_count,this->arena);
+      if (this->player[i].ext_char_id == CharExt::CLIMBER && (followers & (1 << i))) { //Extra player for Ice Climbers
+        this->player[i+4].cols.allocate(this->frame_count,this->arena);
       }
     }
   }
 }
 
-void SlippiReplay::cleanup() {
-  for(unsigned i = 0; i < 4; ++i) {
-    if (this->player[i].player_type != 3) {
-      delete [] this->player[i].frame;
-      if (this->player[i].ext_char_id == CharExt::CLIMBER) { //Extra player for Ice Climbers
-        delete [] this->player[i+4].frame;
-      }
+//Reallocate every allocated frame column, keeping frames that have already been read
+void SlippiReplay::growFrames(int32_t old_max_frames, int32_t new_max_frames) {
+  unsigned new_count = new_max_frames-this->first_frame;
+  for(unsigned i = 0; i < 8; ++i) {
+    if (this->player[i].cols.empty()) {
+      continue;
     }
+    this->player[i].cols.resize(new_count);
+  }
+}
+
+//Free frame storage (arena-backed storage is left for the arena's owner to reset)
+void SlippiReplay::cleanup() {
+  for(unsigned i = 0; i < 8; ++i) {
+    this->player[i].cols.release();
   }
-  for(unsigned i = 0; i < MAX_ITEMS; ++i) {
-    if (this->item[i].frame != nullptr) {
-      delete [] this->item[i].frame;
+  if (this->arena == nullptr) {
+    for (SlippiItem& it : this->items) {
+      it.release();
     }
   }
+  this->items.clear();
+  this->item_index.clear();
 }
 
-arrow::Status SlippiReplay::playerFramesAsParquet() {
+//Orders platform changes by frame for std::upper_bound
+static inline bool beforePlatformChange(int32_t f, const SlippiFodPlatformFrame& c) {
+  return f < c.frame;
+}
 
-  SlippiReplay s = (*this);
+void SlippiReplay::setPlatformHeight(int32_t f, uint8_t platform, float height) {
+  if (platform > 1) {
+    return;  //Only the right (0) and left (1) platforms move
+  }
+  //Events arrive in frame order, so this is almost always an append
+  auto it = std::upper_bound(platform_changes.begin(), platform_changes.end(), f, beforePlatformChange);
+  if (it == platform_changes.begin() || (it-1)->frame != f) {
+    it = platform_changes.insert(it, platformsAt(f));  //Start from the heights in effect at f
+  } else {
+    --it;
+  }
+  //The new height holds from f onward, including over any later changes already recorded
+  for( ; it != platform_changes.end(); ++it) {
+    (platform == 0 ? it->right_height : it->left_height) = height;
+  }
+}
 
-  uint8_t _slippi_maj = (s.slippi_version_raw >> 24) & 0xff;
-  uint8_t _slippi_min = (s.slippi_version_raw >> 16) & 0xff;
-  uint8_t _slippi_rev = (s.slippi_version_raw >>  8) & 0xff;
+SlippiFodPlatformFrame SlippiReplay::platformsAt(int32_t f) const {
+  auto it = std::upper_bound(platform_changes.begin(), platform_changes.end(), f, beforePlatformChange);
+  SlippiFodPlatformFrame heights = { f, FOD_LEFT_HEIGHT, FOD_RIGHT_HEIGHT };
+  if (it != platform_changes.begin()) {
+    heights.left_height  = (it-1)->left_height;
+    heights.right_height = (it-1)->right_height;
+  }
+  return heights;
+}
 
-  using arrow::FloatBuilder;
-  using arrow::UInt8Builder;
-  using arrow::UInt16Builder;
-  using arrow::UInt32Builder;
-  using arrow::BooleanBuilder;
-  using arrow::StringBuilder;
+//Ports that get player frame rows
+static inline bool writesFrames(const ReplayView& s, unsigned p) {
+  return s->player[p].player_type != 3 && !s->player[p].cols.empty();
+}
 
+//Frame columns written to Parquet as stored by the parser, in schema order (after
+//  the identifying columns), as X(name,arrow type)
+#define PLAYER_FRAME_PARQUET_FIELDS(X) \
+  X(char_id,uint8) X(follower,boolean) X(seed,uint32) X(ucf_x,uint8) X(stocks,uint8) \
+  X(alive,boolean) X(anim_index,uint32) X(pos_x_pre,float32) X(pos_y_pre,float32) \
+  X(pos_x_post,float32) X(pos_y_post,float32) X(joy_x,float32) X(joy_y,float32) \
+  X(c_x,float32) X(c_y,float32) X(trigger,float32) X(buttons,uint16) X(phys_l,float32) \
+  X(phys_r,float32) X(shield,float32) X(hit_with,uint8) X(combo,uint8) X(hurt_by,uint8) \
+  X(percent_pre,float32) X(percent_post,float32) X(action_pre,uint16) X(action_post,uint16) \
+  X(action_fc,float32) X(face_dir_pre,float32) X(face_dir_post,float32) X(hitstun,float32) \
+  X(airborne,boolean) X(ground_id,uint16) X(jumps,uint8) X(l_cancel,uint8) X(hurtbox,uint8) \
+  X(hitlag,float32) X(self_air_x,float32) X(self_air_y,float32) X(attack_x,float32) \
+  X(attack_y,float32) X(self_grd_x,float32)
+
+//Arrow state for PlayerFrameWriter. Frame columns are wrapped in place as Arrow buffers
+//  rather than appended row by row, and match_id / player_id are dictionary-encoded, so
+//  building a row group costs O(columns) plus numbering its frames (flags are stored as
+//  bits already, so they're wrapped too). Buffers for the columns the parser doesn't store are reused for every row group.
+struct PlayerFrameWriter::Columns {
+  std::shared_ptr<arrow::DataType> dict_type = arrow::dictionary(arrow::int8(), arrow::utf8());
   std::shared_ptr<arrow::Schema> schema = arrow::schema({
-    arrow::field("match_id", arrow::utf8()),
-    arrow::field("player_id", arrow::utf8()),
+    arrow::field("match_id", dict_type),
+    arrow::field("player_id", dict_type),
     arrow::field("player_index", arrow::uint8()),
     arrow::field("frame_number", arrow::uint32()),
-    arrow::field("char_id", arrow::uint8()),
-    arrow::field("follower", arrow::boolean()),
-    arrow::field("seed", arrow::uint32()),
-    arrow::field("ucf_x", arrow::uint8()),
-    arrow::field("stocks", arrow::uint8()),
-    arrow::field("alive", arrow::boolean()),
-    arrow::field("anim_index", arrow::uint32()),
-    arrow::field("pos_x_pre", arrow::float32()),
-    arrow::field("pos_y_pre", arrow::float32()),
-    arrow::field("pos_x_post", arrow::float32()),
-    arrow::field("pos_y_post", arrow::float32()),
-    arrow::field("joy_x", arrow::float32()),
-    arrow::field("joy_y", arrow::float32()),
-    arrow::field("c_x", arrow::float32()),
-    arrow::field("c_y", arrow::float32()),
-    arrow::field("trigger", arrow::float32()),
-    arrow::field("buttons", arrow::uint16()),
-    arrow::field("phys_l", arrow::float32()),
-    arrow::field("phys_r", arrow::float32()),
-    arrow::field("shield", arrow::float32()),
-    arrow::field("hit_with", arrow::uint8()),
-    arrow::field("combo", arrow::uint8()),
-    arrow::field("hurt_by", arrow::uint8()),
-    arrow::field("percent_pre", arrow::float32()),
-    arrow::field("percent_post", arrow::float32()),
-    arrow::field("action_pre", arrow::uint16()),
-    arrow::field("action_post", arrow::uint16()),
-    arrow::field("action_fc", arrow::float32()),
-    arrow::field("face_dir_pre", arrow::float32()),
-    arrow::field("face_dir_post", arrow::float32()),
-    arrow::field("hitstun", arrow::float32()),
-    arrow::field("airborne", arrow::boolean()),
-    arrow::field("ground_id", arrow::uint16()),
-    arrow::field("jumps", arrow::uint8()),
-    arrow::field("l_cancel", arrow::uint8()),
-    arrow::field("hurtbox", arrow::uint8()),
-    arrow::field("hitlag", arrow::float32()),
-    arrow::field("self_air_x", arrow::float32()),
-    arrow::field("self_air_y", arrow::float32()),
-    arrow::field("attack_x", arrow::float32()),
-    arrow::field("attack_y", arrow::float32()),
-    arrow::field("self_grd_x", arrow::float32()),
+#define PARQUET_FIELD(name,type) arrow::field(#name, arrow::type()),
+    PLAYER_FRAME_PARQUET_FIELDS(PARQUET_FIELD)
+#undef PARQUET_FIELD
   });
+  std::vector<arrow::ArrayVector>   chunks;        //Each column's arrays (one per player) for the current row group
+  std::vector<uint32_t>             frame_numbers; //Frame numbers of the current row group
+  std::vector<uint8_t>              ports[8];      //Each player's index repeated (doubles as its player_id dictionary index)
+  std::vector<uint8_t>              zeros;         //All zeros (the match_id dictionary index, and flags a version lacks)
+
+  //Zero-copy array over frames [first,first+n) of a parser-owned column
+  template <typename T>
+  std::shared_ptr<arrow::Array> wrap(const T* col, uint32_t first, uint32_t n) {
+    using ArrayType = typename arrow::CTypeTraits<T>::ArrayType;
+    return std::make_shared<ArrayType>(n, arrow::Buffer::Wrap(col, first+n), nullptr, 0, first);
+  }
 
-  UInt8Builder ucf_x_b, char_id_b, hit_with_b, combo_b, hurt_by_b, stocks_b;
-  UInt8Builder jumps_b, l_cancel_b, hurtbox_b, player_index_b;
-  UInt16Builder action_pre_b, action_post_b, buttons_b, ground_id_b;
-  UInt32Builder frame_number_b, seed_b, anim_index_b;
-  FloatBuilder pos_x_pre_b, pos_y_pre_b, joy_x_b, joy_y_b, c_x_b, c_y_b;
-  FloatBuilder trigger_b, pos_x_post_b, pos_y_post_b, phys_l_b, phys_r_b;
-  FloatBuilder percent_pre_b, percent_post_b, face_dir_pre_b, face_dir_post_b, shield_b;
-  FloatBuilder action_fc_b, hitstun_b, self_air_x_b, self_air_y_b;
-  FloatBuilder attack_x_b, attack_y_b, self_grd_x_b, hitlag_b;
-  BooleanBuilder follower_b, alive_b, airborne_b;
-  StringBuilder match_id_b, player_id_b;
+  //Flags are stored as Arrow-ordered bits already, so they're wrapped in place too (nullptr = all false)
+  std::shared_ptr<arrow::Array> wrap(const FrameBits& col, uint32_t first, uint32_t n) {
+    if (col.bits == nullptr) {
+      return std::make_shared<arrow::BooleanArray>(n, arrow::Buffer::Wrap(zeros.data(), (n+7)/8));
+    }
+    return std::make_shared<arrow::BooleanArray>(n, arrow::Buffer::Wrap(col.bits, (first+n+7)/8), nullptr, 0, first);
+  }
 
-  for(unsigned p = 0; p < 8; ++p) {
-    unsigned pp = (p % 4);
-
-    if (s.player[p].player_type != 3) {
-      for(unsigned f = 0; f < s.frame_count; ++f) {
-
-        match_id_b.Append(s.start_time);
-        player_id_b.Append(s.player[pp].tag_code);
-        player_index_b.Append(p);
-        frame_number_b.Append(f);
-        char_id_b.Append(s.player[p].frame[f].char_id);
-        follower_b.Append(s.player[p].frame[f].follower);
-        seed_b.Append(s.player[p].frame[f].seed);
-        pos_x_pre_b.Append(s.player[p].frame[f].pos_x_pre);
-        pos_y_pre_b.Append(s.player[p].frame[f].pos_y_pre);
-        face_dir_pre_b.Append(s.player[p].frame[f].face_dir_pre);
-        joy_x_b.Append(s.player[p].frame[f].joy_x);
-        joy_y_b.Append(s.player[p].frame[f].joy_y);
-        c_x_b.Append(s.player[p].frame[f].c_x);
-        c_y_b.Append(s.player[p].frame[f].c_y);
-        trigger_b.Append(s.player[p].frame[f].trigger);
-        buttons_b.Append(s.player[p].frame[f].buttons);
-        phys_l_b.Append(s.player[p].frame[f].phys_l);
-        phys_r_b.Append(s.player[p].frame[f].phys_r);
-        ucf_x_b.Append(s.player[p].frame[f].ucf_x);
-        percent_pre_b.Append(s.player[p].frame[f].percent_pre);
-        action_pre_b.Append(s.player[p].frame[f].action_pre);
-        action_post_b.Append(s.player[p].frame[f].action_post);
-        pos_x_post_b.Append(s.player[p].frame[f].pos_x_post);
-        pos_y_post_b.Append(s.player[p].frame[f].pos_y_post);
-        face_dir_post_b.Append(s.player[p].frame[f].face_dir_post);
-        percent_post_b.Append(s.player[p].frame[f].percent_post);
-        shield_b.Append(s.player[p].frame[f].shield);
-        hit_with_b.Append(s.player[p].frame[f].hit_with);
-        combo_b.Append(s.player[p].frame[f].combo);
-        hurt_by_b.Append(s.player[p].frame[f].hurt_by);
-        stocks_b.Append(s.player[p].frame[f].stocks);
-        action_fc_b.Append(s.player[p].frame[f].action_fc);
-
-        if(MIN_VERSION(2,0,0)) {
-          hitstun_b.Append(s.player[p].frame[f].hitstun);
-          airborne_b.Append(s.player[p].frame[f].airborne);
-          ground_id_b.Append(s.player[p].frame[f].ground_id);
-          jumps_b.Append(s.player[p].frame[f].jumps);
-          l_cancel_b.Append(s.player[p].frame[f].l_cancel);
-          alive_b.Append(s.player[p].frame[f].alive);
-        } else {
-          hitstun_b.Append(0);
-          airborne_b.Append(false);
-          ground_id_b.Append(0);
-          jumps_b.Append(0);
-          l_cancel_b.Append(0);
-          alive_b.Append(false);
-        }
-
-        if(MIN_VERSION(2,1,0)) {
-          hurtbox_b.Append(s.player[p].frame[f].hurtbox);
-        } else {
-          hurtbox_b.Append(0);
-        }
-
-        if(MIN_VERSION(3,5,0)) {
-          self_air_x_b.Append(s.player[p].frame[f].self_air_x);
-          self_air_y_b.Append(s.player[p].frame[f].self_air_y);
-          attack_x_b.Append(s.player[p].frame[f].attack_x);
-          attack_y_b.Append(s.player[p].frame[f].attack_y);
-          self_grd_x_b.Append(s.player[p].frame[f].self_grd_x);
-        } else {
-          self_air_x_b.Append(0);
-          self_air_y_b.Append(0);
-          attack_x_b.Append(0);
-          attack_y_b.Append(0);
-          self_grd_x_b.Append(0);
-        }
-
-        if(MIN_VERSION(3,8,0)) {
-          hitlag_b.Append(s.player[p].frame[f].hitlag);
-        } else {
-          hitlag_b.Append(0);
-        }
-
-        if(MIN_VERSION(3,11,0)) {
-          anim_index_b.Append(s.player[p].frame[f].anim_index);
-        } else {
-          anim_index_b.Append(0);
-        }
+  //Dictionary-encoded array of n rows whose indices come from a buffer we own
+  std::shared_ptr<arrow::Array> encode(const std::vector<uint8_t>& indices, uint32_t n, const std::shared_ptr<arrow::Array>& dict) {
+    std::shared_ptr<arrow::Array> encoded;
+    PARQUET_ASSIGN_OR_THROW(encoded, arrow::DictionaryArray::FromArrays(dict_type,
+      std::make_shared<arrow::Int8Array>(n, arrow::Buffer::Wrap(indices.data(), n)), dict));
+    return encoded;
+  }
+
+  //Make sure the shared buffers cover n rows starting at frame first
+  void reserve(uint32_t first, uint32_t n) {
+    if (zeros.size() < n) {
+      zeros.assign(n, 0);
+      for(unsigned p = 0; p < 8; ++p) {
+        ports[p].assign(n, p);
       }
     }
+    frame_numbers.resize(n);
+    for(uint32_t i = 0; i < n; ++i) {
+      frame_numbers[i] = first+i;
+    }
   }
 
-  std::shared_ptr<arrow::Array> match_id_a, player_id_a, player_index_a, frame_number_a, char_id_a, follower_a, seed_a, ucf_x_a, stocks_a, alive_a, anim_index_a;
-  std::shared_ptr<arrow::Array> pos_x_pre_a, pos_y_pre_a, pos_x_post_a, pos_y_post_a, joy_x_a, joy_y_a;
-  std::shared_ptr<arrow::Array> c_x_a, c_y_a, trigger_a, buttons_a, phys_l_a, phys_r_a, shield_a;
-  std::shared_ptr<arrow::Array> hit_with_a, combo_a, hurt_by_a, percent_pre_a, percent_post_a;
-  std::shared_ptr<arrow::Array> action_pre_a, action_post_a, action_fc_a, face_dir_pre_a, face_dir_post_a;
-  std::shared_ptr<arrow::Array> hitstun_a, airborne_a, ground_id_a, jumps_a, l_cancel_a, hurtbox_a, hitlag_a;
-  std::shared_ptr<arrow::Array> self_air_x_a, self_air_y_a, attack_x_a, attack_y_a, self_grd_x_a;
+  //Add frames [first,first+n) of every player (or just one) to the current row group, returning the rows added
+  uint32_t add(const ReplayView& s, uint32_t first, uint32_t n, int only = -1) {
+    uint8_t _slippi_maj = (s->slippi_version_raw >> 24) & 0xff;
+    uint8_t _slippi_min = (s->slippi_version_raw >> 16) & 0xff;
+    uint8_t _slippi_rev = (s->slippi_version_raw >>  8) & 0xff;
 
-  match_id_b.Finish(&match_id_a);
-  player_id_b.Finish(&player_id_a);
-  player_index_b.Finish(&player_index_a);
-  frame_number_b.Finish(&frame_number_a);
-  char_id_b.Finish(&char_id_a);
-  follower_b.Finish(&follower_a);
-  seed_b.Finish(&seed_a);
-  ucf_x_b.Finish(&ucf_x_a);
-  stocks_b.Finish(&stocks_a);
-  alive_b.Finish(&alive_a);
-  anim_index_b.Finish(&anim_index_a);
-  pos_x_pre_b.Finish(&pos_x_pre_a);
-  pos_y_pre_b.Finish(&pos_y_pre_a);
-  pos_x_post_b.Finish(&pos_x_post_a);
-  pos_y_post_b.Finish(&pos_y_post_a);
-  joy_x_b.Finish(&joy_x_a);
-  joy_y_b.Finish(&joy_y_a);
-  c_x_b.Finish(&c_x_a);
-  c_y_b.Finish(&c_y_a);
-  trigger_b.Finish(&trigger_a);
-  buttons_b.Finish(&buttons_a);
-  phys_l_b.Finish(&phys_l_a);
-  phys_r_b.Finish(&phys_r_a);
-  shield_b.Finish(&shield_a);
-  hit_with_b.Finish(&hit_with_a);
-  combo_b.Finish(&combo_a);
-  hurt_by_b.Finish(&hurt_by_a);
-  percent_pre_b.Finish(&percent_pre_a);
-  percent_post_b.Finish(&percent_post_a);
-  action_pre_b.Finish(&action_pre_a);
-  action_post_b.Finish(&action_post_a);
-  action_fc_b.Finish(&action_fc_a);
-  face_dir_pre_b.Finish(&face_dir_pre_a);
-  face_dir_post_b.Finish(&face_dir_post_a);
-  hitstun_b.Finish(&hitstun_a);
-  airborne_b.Finish(&airborne_a);
-  ground_id_b.Finish(&ground_id_a);
-  jumps_b.Finish(&jumps_a);
-  l_cancel_b.Finish(&l_cancel_a);
-  hurtbox_b.Finish(&hurtbox_a);
-  hitlag_b.Finish(&hitlag_a);
-  self_air_x_b.Finish(&self_air_x_a);
-  self_air_y_b.Finish(&self_air_y_a);
-  attack_x_b.Finish(&attack_x_a);
-  attack_y_b.Finish(&attack_y_a);
-  self_grd_x_b.Finish(&self_grd_x_a);
+    //Fields a replay's version doesn't have are never written by the parser and stay zeroed,
+    //  so the only per-version difference left is that pre-2.0.0 frames report as not alive
+    const bool has_alive = MIN_VERSION(2,0,0);
 
-  std::shared_ptr<arrow::Table> table = arrow::Table::Make(schema, {
-    match_id_a, player_id_a, player_index_a, frame_number_a, char_id_a, follower_a, seed_a, ucf_x_a, stocks_a, alive_a, anim_index_a,
-    pos_x_pre_a, pos_y_pre_a, pos_x_post_a, pos_y_post_a, joy_x_a, joy_y_a, c_x_a, c_y_a, trigger_a,
-    buttons_a, phys_l_a, phys_r_a, shield_a, hit_with_a, combo_a, hurt_by_a, percent_pre_a,
-    percent_post_a, action_pre_a, action_post_a, action_fc_a, face_dir_pre_a, face_dir_post_a, hitstun_a, airborne_a,
-    ground_id_a, jumps_a, l_cancel_a, hurtbox_a, hitlag_a,
-    self_air_x_a, self_air_y_a, attack_x_a, attack_y_a, self_grd_x_a
-  });
+    reserve(first,n);
+    chunks.assign(schema->num_fields(), arrow::ArrayVector());
+
+    arrow::StringBuilder match_b, player_b;
+    std::shared_ptr<arrow::Array> match_dict, player_dict;
+    PARQUET_THROW_NOT_OK(match_b.Append(s->start_time));
+    for(unsigned p = 0; p < 8; ++p) {
+      PARQUET_THROW_NOT_OK(player_b.Append(s->player[p % 4].tag_code));
+    }
+    PARQUET_THROW_NOT_OK(match_b.Finish(&match_dict));
+    PARQUET_THROW_NOT_OK(player_b.Finish(&player_dict));
 
-  try {
-    std::shared_ptr<arrow::io::FileOutputStream> outfile;
-    PARQUET_ASSIGN_OR_THROW(outfile, arrow::io::FileOutputStream::Open("/tmp/frames.parquet"));
-
-    std::shared_ptr<arrow::io::OutputStream> outstream =
-      std::static_pointer_cast<arrow::io::OutputStream>(outfile);
-
-    // TODO: switch to snappy
-    std::shared_ptr<parquet::WriterProperties> writer_properties =
-      parquet::WriterProperties::Builder()
-        .compression(parquet::Compression::UNCOMPRESSED)
-        ->build();
-
-    PARQUET_THROW_NOT_OK(
-      parquet::arrow::WriteTable(*table, arrow::default_memory_pool(), outstream, 1024, writer_properties)
-    );
-  } catch (const parquet::ParquetException& e) {
-    std::cerr << "[ParquetException] " << e.what() << std::endl;
-    return arrow::Status::ExecutionError("ParquetException: ", e.what());
-  } catch (const std::exception& e) {
-    std::cerr << "[std::exception] " << e.what() << std::endl;
-    return arrow::Status::ExecutionError("std::exception: ", e.what());
-  } catch (...) {
-    std::cerr << "[Unknown error] during Parquet file write." << std::endl;
-    return arrow::Status::ExecutionError("Unknown error during Parquet write");
+    uint32_t rows = 0;
+    for(unsigned p = 0; p < 8; ++p) {
+      if (not writesFrames(s,p) || (only >= 0 && int(p) != only)) {
+        continue;
+      }
+      FrameColumns c = s.player(p).cols;  //Shallow copy of the column pointers
+      if (not has_alive) {
+        c.alive.bits = nullptr;
+      }
+      unsigned col = 0;
+      chunks[col++].push_back(encode(zeros, n, match_dict));
+      chunks[col++].push_back(encode(ports[p], n, player_dict));
+      chunks[col++].push_back(wrap(ports[p].data(), 0, n));
+      chunks[col++].push_back(wrap(frame_numbers.data(), 0, n));
+#define PARQUET_COLUMN(name,type) chunks[col++].push_back(wrap(c.name, first, n));
+      PLAYER_FRAME_PARQUET_FIELDS(PARQUET_COLUMN)
+#undef PARQUET_COLUMN
+      rows += n;
+    }
+    return rows;
+  }
+
+  //Table over everything added since the last call (only valid until the next add())
+  std::shared_ptr<arrow::Table> table(uint32_t rows) {
+    std::vector<std::shared_ptr<arrow::ChunkedArray>> columns;
+    for(int i = 0; i < schema->num_fields(); ++i) {
+      columns.push_back(std::make_shared<arrow::ChunkedArray>(chunks[i], schema->field(i)->type()));
+    }
+    return arrow::Table::Make(schema, columns, rows);
+  }
+};
+
+PlayerFrameWriter::PlayerFrameWriter() = default;
+PlayerFrameWriter::~PlayerFrameWriter() = default;
+
+arrow::Status PlayerFrameWriter::open(const OutputSink& sink, const ParquetOptions& o) {
+  std::unique_ptr<ParquetAppender> own(new ParquetAppender(sink,"frames",o));
+  ARROW_RETURN_NOT_OK(open(*own));
+  arrow::Status status = own->open(*_columns->schema);  //Open now, so errors show up before parsing
+  if (!status.ok()) {
+    _out = nullptr;
+    return status;
   }
+  _own = std::move(own);
+  return status;
+}
 
+arrow::Status PlayerFrameWriter::open(ParquetAppender& out) {
+  _own.reset();
+  _out            = &out;
+  _row_group_rows = std::max(out.options().row_group_rows,1u);
+  _sorted         = out.options().sorted;
+  _written        = 0;
+  _row_groups     = 0;
+  _peak_rows      = 0;
+  if (_columns == nullptr) {
+    _columns.reset(new Columns());
+  }
   return arrow::Status::OK();
 }
 
-arrow::Status SlippiReplay::itemFramesAsParquet() {
-  SlippiReplay s = (*this);
+arrow::Status PlayerFrameWriter::_writeRows(const ReplayView& s, uint32_t frames, int player) {
+  arrow::Status status = parquetWrite([&]() {
+    uint32_t rows = _columns->add(s,_written,frames-_written,player);
+    _peak_rows    = std::max(_peak_rows,rows);
+    std::shared_ptr<arrow::Table> table = _columns->table(rows);
+    PARQUET_THROW_NOT_OK(_out->append(*table, std::max(rows,1u)));  //Exactly one row group
+  });
+  _written = frames;
+  ++_row_groups;
+  return status;
+}
+
+arrow::Status PlayerFrameWriter::write(const SlippiReplay& r, uint32_t frames) {
+  if (not isOpen()) {
+    return arrow::Status::Invalid("Player frame writer is not open");
+  }
+  if (_sorted) {
+    return arrow::Status::OK();  //Player-major rows can't be written until every frame is in
+  }
+  const ReplayView s(r);
+  uint32_t players = 0;
+  for(unsigned p = 0; p < 8; ++p) {
+    players += writesFrames(s,p);
+  }
+  //Whole row groups only; whatever's left over waits for more frames (or close())
+  uint32_t per_group = std::max(_row_group_rows/std::max(players,1u),1u);
+  while (frames >= _written+per_group) {
+    ARROW_RETURN_NOT_OK(_writeRows(s,_written+per_group));
+  }
+  return arrow::Status::OK();
+}
+
+arrow::Status PlayerFrameWriter::close(const SlippiReplay& r) {
+  if (not isOpen()) {
+    return arrow::Status::OK();
+  }
+  const ReplayView s(r);
+  arrow::Status status = write(r,r.frame_count);
+  //Sorted: each player's frames in turn, so rows run in (player_index, frame_number) order
+  //  across the whole replay and each row group covers one player's frame window
+  for(unsigned p = 0; _sorted && p < 8 && status.ok(); ++p) {
+    if (not writesFrames(s,p)) {
+      continue;
+    }
+    for(_written = 0; status.ok() && _written < r.frame_count; ) {
+      status = _writeRows(s,std::min(_written+_row_group_rows,r.frame_count),p);
+    }
+  }
+  //A file of our own gets a row group even if it's empty; a shared file doesn't need one
+  if (status.ok() && (_written < r.frame_count || (_own && _row_groups == 0))) {
+    status = _writeRows(s,std::max(_written,r.frame_count));
+  }
+  arrow::Status closed = _own ? _own->close() : arrow::Status::OK();
+  _own.reset();
+  _out = nullptr;
+  return status.ok() ? closed : status;
+}
+
+arrow::Status SlippiReplay::playerFramesAsParquet(const OutputSink& sink, const ParquetOptions& o) {
+  PlayerFrameWriter writer;
+  ARROW_RETURN_NOT_OK(writer.open(sink,o));
+  return writer.close(*this);
+}
+
+arrow::Status SlippiReplay::playerFramesAsParquet(ParquetAppender& out) {
+  PlayerFrameWriter writer;
+  ARROW_RETURN_NOT_OK(writer.open(out));
+  return writer.close(*this);
+}
+
+arrow::Status SlippiReplay::itemFramesAsParquet(const OutputSink& sink, const ParquetOptions& o) {
+  ParquetAppender out(sink,"items",o);
+  ARROW_RETURN_NOT_OK(itemFramesAsParquet(out));
+  return out.close();
+}
+
+arrow::Status SlippiReplay::itemFramesAsParquet(ParquetAppender& out) {
+  const ReplayView s(*this);
 
-  uint8_t _slippi_maj = (s.slippi_version_raw >> 24) & 0xff;
-  uint8_t _slippi_min = (s.slippi_version_raw >> 16) & 0xff;
-  uint8_t _slippi_rev = (s.slippi_version_raw >>  8) & 0xff;
+  uint8_t _slippi_maj = (s->slippi_version_raw >> 24) & 0xff;
+  uint8_t _slippi_min = (s->slippi_version_raw >> 16) & 0xff;
+  uint8_t _slippi_rev = (s->slippi_version_raw >>  8) & 0xff;
 
   using arrow::FloatBuilder;
   using arrow::UInt8Builder;
@@ -350,40 +534,31 @@ arrow::Status SlippiReplay::itemFramesAsParquet() {
   UInt32Builder frame_b, spawn_id_b;
   StringBuilder match_id_b;
 
-  for (unsigned i = 0; i < MAX_ITEMS; ++i) {
-    if (s.item[i].spawn_id > MAX_ITEMS || s.item[i].num_frames == 0) {
-      continue; // Skip uninitialized items
-    }
-    for (unsigned f = 0; f < s.item[i].num_frames; ++f) {
-      match_id_b.Append(s.start_time);
-      spawn_id_b.Append(s.item[i].spawn_id);
-      item_type_b.Append(s.item[i].type);
-      frame_b.Append(s.item[i].frame[f].frame + 123);
-      state_b.Append(s.item[i].frame[f].state);
-      face_dir_b.Append(s.item[i].frame[f].face_dir);
-      xvel_b.Append(s.item[i].frame[f].xvel);
-      yvel_b.Append(s.item[i].frame[f].yvel);
-      xpos_b.Append(s.item[i].frame[f].xpos);
-      ypos_b.Append(s.item[i].frame[f].ypos);
-      damage_b.Append(s.item[i].frame[f].damage);
-      expire_b.Append(s.item[i].frame[f].expire);
-
-      if (MIN_VERSION(3, 2, 0)) {
-        missile_type_b.Append(s.item[i].frame[f].flags_1);
-        turnip_face_b.Append(s.item[i].frame[f].flags_2);
-        is_launched_b.Append(s.item[i].frame[f].flags_3);
-        charged_power_b.Append(s.item[i].frame[f].flags_4);
-      } else {
-        missile_type_b.Append(0);
-        turnip_face_b.Append(0);
-        is_launched_b.Append(0);
-        charged_power_b.Append(0);
-      }
-
-      if (MIN_VERSION(3, 6, 0)) {
-        owner_b.Append(s.item[i].frame[f].owner);
-      } else {
-        owner_b.Append(-1);
+  //As with player frames, fields missing from older versions are already zeroed;
+  //  only the owner needs an explicit "unowned" value before 3.6.0
+  const bool has_owner = MIN_VERSION(3,6,0);
+
+  for (const SlippiItem& it : s->items) {
+    for (const SlippiItemRun* run = it.first; run != nullptr; run = run->next) {
+      for (unsigned f = 0; f < run->count; ++f) {
+        const SlippiItemFrame& fr = run->frame[f];
+        match_id_b.Append(s->start_time);
+        spawn_id_b.Append(it.spawn_id);
+        item_type_b.Append(it.type);
+        frame_b.Append(fr.frame + 123);
+        state_b.Append(fr.state);
+        face_dir_b.Append(fr.face_dir);
+        xvel_b.Append(fr.xvel);
+        yvel_b.Append(fr.yvel);
+        xpos_b.Append(fr.xpos);
+        ypos_b.Append(fr.ypos);
+        damage_b.Append(fr.damage);
+        expire_b.Append(fr.expire);
+        missile_type_b.Append(fr.flags_1);
+        turnip_face_b.Append(fr.flags_2);
+        is_launched_b.Append(fr.flags_3);
+        charged_power_b.Append(fr.flags_4);
+        owner_b.Append(has_owner ? fr.owner : -1);
       }
     }
   }
@@ -418,46 +593,30 @@ arrow::Status SlippiReplay::itemFramesAsParquet() {
     owner_a
   });
 
-  try {
-    std::shared_ptr<arrow::io::FileOutputStream> outfile;
-    PARQUET_ASSIGN_OR_THROW(outfile, arrow::io::FileOutputStream::Open("/tmp/items.parquet"));
-
-    std::shared_ptr<arrow::io::OutputStream> outstream =
-      std::static_pointer_cast<arrow::io::OutputStream>(outfile);
-
-    // TODO: switch from to snappy
-    std::shared_ptr<parquet::WriterProperties> writer_properties =
-      parquet::WriterProperties::Builder()
-        .compression(parquet::Compression::UNCOMPRESSED)
-        ->build();
-
-    PARQUET_THROW_NOT_OK(
-      parquet::arrow::WriteTable(*table, arrow::default_memory_pool(), outstream, 1024, writer_properties)
-    );
-  } catch (const parquet::ParquetException& e) {
-    std::cerr << "[ParquetException] " << e.what() << std::endl;
-    return arrow::Status::ExecutionError("ParquetException: ", e.what());
-  } catch (const std::exception& e) {
-    std::cerr << "[std::exception] " << e.what() << std::endl;
-    return arrow::Status::ExecutionError("std::exception: ", e.what());
-  } catch (...) {
-    std::cerr << "[Unknown error] during Parquet file write." << std::endl;
-    return arrow::Status::ExecutionError("Unknown error during Parquet write");
-  }
-
-  return arrow::Status::OK();
+  return out.append(*table);
 }
 
 
 
-arrow::Status SlippiReplay::fodPlatformFramesAsParquet() {
-  SlippiReplay s = (*this);
+arrow::Status SlippiReplay::fodPlatformFramesAsParquet(const OutputSink& sink, const ParquetOptions& o) {
+  ParquetAppender out(sink,"platforms",o);
+  ARROW_RETURN_NOT_OK(fodPlatformFramesAsParquet(out));
+  return out.close();
+}
 
-  uint8_t _slippi_maj = (s.slippi_version_raw >> 24) & 0xff;
-  uint8_t _slippi_min = (s.slippi_version_raw >> 16) & 0xff;
-  uint8_t _slippi_rev = (s.slippi_version_raw >>  8) & 0xff;
+arrow::Status SlippiReplay::fodPlatformFramesAsParquet(ParquetAppender& out) {
+  const ReplayView s(*this);
 
-  if (!s.platform_frames.empty()) {
+  uint8_t _slippi_maj = (s->slippi_version_raw >> 24) & 0xff;
+  uint8_t _slippi_min = (s->slippi_version_raw >> 16) & 0xff;
+  uint8_t _slippi_rev = (s->slippi_version_raw >>  8) & 0xff;
+
+  bool has_frames = false;  //Summarized replays have no frame data to line platforms up with
+  for(unsigned p = 0; p < 8; ++p) {
+    has_frames |= !s->player[p].cols.empty();
+  }
+
+  if (s->stage == 2 && has_frames) {
 
     using arrow::FloatBuilder;
     using arrow::UInt32Builder;
@@ -475,10 +634,16 @@ arrow::Status SlippiReplay::fodPlatformFramesAsParquet() {
     UInt32Builder frame_b;
     StringBuilder match_id_b;
 
-    for (size_t i = 0; i < s.platform_frames.size(); ++i) {
-      const auto& e = s.platform_frames[i];
-      match_id_b.Append(s.start_time);
-      frame_b.Append(e.frame);
+    //Expand the platform changes into one row per frame
+    const std::vector<SlippiFodPlatformFrame>& changes = s->platform_changes;
+    SlippiFodPlatformFrame e = { 0, FOD_LEFT_HEIGHT, FOD_RIGHT_HEIGHT };
+    size_t next = 0;  //Next change to take effect
+    for (uint32_t f = 0; f < s->frame_count; ++f) {
+      while (next < changes.size() && changes[next].frame <= int32_t(f)) {
+        e = changes[next++];
+      }
+      match_id_b.Append(s->start_time);
+      frame_b.Append(f);
       left_height_b.Append(e.left_height);
       right_height_b.Append(e.right_height);
     }
@@ -494,97 +659,95 @@ arrow::Status SlippiReplay::fodPlatformFramesAsParquet() {
       match_id_a, frame_a, left_height_a, right_height_a
     });
 
-    try {
-      std::shared_ptr<arrow::io::FileOutputStream> outfile;
-      PARQUET_ASSIGN_OR_THROW(outfile, arrow::io::FileOutputStream::Open("/tmp/platforms.parquet"));
-
-      std::shared_ptr<arrow::io::OutputStream> outstream =
-        std::static_pointer_cast<arrow::io::OutputStream>(outfile);
-
-      // TODO: switch from to snappy
-      std::shared_ptr<parquet::WriterProperties> writer_properties =
-        parquet::WriterProperties::Builder()
-          .compression(parquet::Compression::UNCOMPRESSED)
-          ->build();
-
-      PARQUET_THROW_NOT_OK(
-        parquet::arrow::WriteTable(*table, arrow::default_memory_pool(), outstream, 1024, writer_properties)
-      );
-    } catch (const parquet::ParquetException& e) {
-      std::cerr << "[ParquetException] " << e.what() << std::endl;
-      return arrow::Status::ExecutionError("ParquetException: ", e.what());
-    } catch (const std::exception& e) {
-      std::cerr << "[std::exception] " << e.what() << std::endl;
-      return arrow::Status::ExecutionError("std::exception: ", e.what());
-    } catch (...) {
-      std::cerr << "[Unknown error] during Parquet file write." << std::endl;
-      return arrow::Status::ExecutionError("Unknown error during Parquet write");
-    }
-
-    return arrow::Status::OK();
+    return out.append(*table);
   }
   return arrow::Status::OK();
 }
 
+std::string SlippiReplay::partition() const {
+  //Date from the start time (e.g. 2023-05-01T12:34:56Z); replays without metadata have none
+  std::string date = HIVE_DEFAULT_PARTITION;
+  if (start_time.size() >= 10 && start_time.find_first_not_of("0123456789-") >= 10
+    && start_time[4] == '-' && start_time[7] == '-') {
+    date = start_time.substr(0,10);
+  }
+
+  //Characters in the game, by external ID in ascending order, so it doesn't matter who was on which port
+  std::vector<unsigned> chars;
+  for (unsigned i = 0; i < 4; ++i) {
+    if (player[i].player_type != 3) {
+      chars.push_back(player[i].ext_char_id);
+    }
+  }
+  std::sort(chars.begin(), chars.end());
+  std::string char_ids;
+  for (unsigned i = 0; i < chars.size(); ++i) {
+    char_ids += (i ? "-" : "") + std::to_string(chars[i]);
+  }
+
+  return "stage=" + std::to_string(stage) + "/date=" + date + "/chars="
+    + (char_ids.empty() ? HIVE_DEFAULT_PARTITION : char_ids);
+}
+
 std::string SlippiReplay::settingsAsJson() {
-  SlippiReplay s = (*this);
+  const ReplayView s(*this);
 
-  uint8_t _slippi_maj = (s.slippi_version_raw >> 24) & 0xff;
-  uint8_t _slippi_min = (s.slippi_version_raw >> 16) & 0xff;
-  uint8_t _slippi_rev = (s.slippi_version_raw >>  8) & 0xff;
+  uint8_t _slippi_maj = (s->slippi_version_raw >> 24) & 0xff;
+  uint8_t _slippi_min = (s->slippi_version_raw >> 16) & 0xff;
+  uint8_t _slippi_rev = (s->slippi_version_raw >>  8) & 0xff;
 
   std::stringstream ss;
 
   ss << "{\n";
-  ss << "  " << JSTR("match_id"       ,s.start_time) << ",\n";
-  ss << "  " << JUIN("stage"          ,s.stage) << "\n";
+  ss << "  " << JSTR("match_id"       ,s->start_time) << ",\n";
+  ss << "  " << JUIN("stage"          ,s->stage) << "\n";
   ss << "}" << std::endl;
 
   return ss.str();
 }
 
 std::string SlippiReplay::matchSettingsAsJson(const std::string& filename) {
-  SlippiReplay s = (*this);
+  const ReplayView s(*this);
 
-  uint8_t _slippi_maj = (s.slippi_version_raw >> 24) & 0xff;
-  uint8_t _slippi_min = (s.slippi_version_raw >> 16) & 0xff;
-  uint8_t _slippi_rev = (s.slippi_version_raw >>  8) & 0xff;
+  uint8_t _slippi_maj = (s->slippi_version_raw >> 24) & 0xff;
+  uint8_t _slippi_min = (s->slippi_version_raw >> 16) & 0xff;
+  uint8_t _slippi_rev = (s->slippi_version_raw >>  8) & 0xff;
 
   std::stringstream ss;
 
   ss << "{";
-  ss << JSTR("match_id"       ,s.start_time) << ",";
+  ss << JSTR("match_id"       ,s->start_time) << ",";
   ss << JSTR("slp_file_name"  ,filename) << ",";
-  ss << JSTR("slippi_version" ,s.slippi_version) << ",";
-  ss << JUIN("timer"          ,s.timer) << ",";
-  ss << JINT("frame_count"    ,s.frame_count) << ",";
-  ss << JINT("winner_id"      ,s.winner_id) << ",";
-  ss << JUIN("stage"          ,s.stage) << ",";
-  ss << JUIN("end_type"       ,s.end_type);
+  ss << JSTR("slippi_version" ,s->slippi_version) << ",";
+  ss << JUIN("timer"          ,s->timer) << ",";
+  ss << JINT("frame_count"    ,s->frame_count) << ",";
+  ss << JINT("winner_id"      ,s->winner_id) << ",";
+  ss << JUIN("stage"          ,s->stage) << ",";
+  ss << JUIN("end_type"       ,s->end_type);
   ss << " }" << std::endl;
 
   return ss.str();
 }
 
 std::string SlippiReplay::playerSettingsAsJson() {
-  SlippiReplay s = (*this);
+  const ReplayView s(*this);
 
-  uint8_t _slippi_maj = (s.slippi_version_raw >> 24) & 0xff;
-  uint8_t _slippi_min = (s.slippi_version_raw >> 16) & 0xff;
-  uint8_t _slippi_rev = (s.slippi_version_raw >>  8) & 0xff;
+  uint8_t _slippi_maj = (s->slippi_version_raw >> 24) & 0xff;
+  uint8_t _slippi_min = (s->slippi_version_raw >> 16) & 0xff;
+  uint8_t _slippi_rev = (s->slippi_version_raw >>  8) & 0xff;
 
   std::stringstream ss;
 
   for (unsigned i = 0; i < 4; ++i) {
-    if (s.player[i].player_type != 3) {
+    if (s->player[i].player_type != 3) {
       ss << "{";
-      ss << JSTR(("match_id")        ,s.start_time)             << ",";
+      ss << JSTR(("match_id")        ,s->start_time)             << ",";
       ss << JINT(("port")            ,i + 1)                    << ",";
-      ss << JSTR(("slippi_code")     ,s.player[i].tag_code)     << ",";
-      ss << JSTR(("player_tag")      ,s.player[i].tag)          << ",";
-      ss << JINT(("player_type")     ,s.player[i].player_type)  << ",";
+      ss << JSTR(("slippi_code")     ,s->player[i].tag_code)     << ",";
+      ss << JSTR(("player_tag")      ,s->player[i].tag)          << ",";
+      ss << JINT(("player_type")     ,s->player[i].player_type)  << ",";
       ss << JINT(("player_index")    ,i)                        << ",";
-      ss << JINT(("ext_char")        ,s.player[i].ext_char_id);
+      ss << JINT(("ext_char")        ,s->player[i].ext_char_id);
       ss << " }" << std::endl;
     }
   }
@@ -3,29 +3,31 @@
 
 #include <iostream>
 #include <fstream>
+#include <vector>
+#include <memory>
 #include <arrow/status.h>
 
 
 #include "enums.h"
 #include "util.h"
+#include "arena.h"
+#include "writer.h"
 
 // Replay File (.slp) Spec: https://github.com/project-slippi/project-slippi/wiki/Replay-File-Spec
 
-const unsigned MAX_ITEMS     = 1024; //Max number of items to output
-const int32_t  MAX_ITEM_LIFE = 1024; //Max number of frames to track an item
+const uint32_t ITEM_RUN_MIN_FRAMES = 16;   //Frames in an item's first run of frames
+const uint32_t ITEM_RUN_MAX_FRAMES = 1024; //Cap on the doubling size of later runs
+const float    FOD_LEFT_HEIGHT     = 20.0f;        //Fountain of Dreams left platform height before it first moves
+const float    FOD_RIGHT_HEIGHT    = 27.44186047f; //Fountain of Dreams right platform height before it first moves
 
 namespace slip {
 
+//One player's frame as a single record, with fields grouped by size so nothing is padded
+//  and the booleans folded into single bits. The in-game frame number and port are left out:
+//  frames are always reached by frame index (fnum - LOAD_FRAME) and player, so both follow
+//  from where the frame is stored.
 struct SlippiFrame {
-  //Parser stuff
-  bool     alive         = false;  //For checking if this frame was actually set
-
-  //Pre-frame stuff
-  int32_t  frame         = 0;      //In-game frame number corresponding to this SlippiFrame (starts at -123)
-  uint8_t  player        = 0;      //Port id of the player (0 = Port 1, 1 = Port 2, etc.)
-  bool     follower      = false;  //Whether this player is a follower (e.g., 2nd climber)
-  uint32_t seed          = 0;      //RNG seed at the beginning of the frame
-  uint16_t action_pre    = 0;      //Action state at the beginning of the frame
+  //Pre-frame floats
   float    pos_x_pre     = 0.0f;   //X position at the beginning of the frame
   float    pos_y_pre     = 0.0f;   //Y position at the beginning of the frame
   float    face_dir_pre  = 0.0f;   //Facing direction at the beginning of the frame (-1 = left, +1 = right)
@@ -34,43 +36,116 @@ struct SlippiFrame {
   float    c_x           = 0.0f;   //C stick X position
   float    c_y           = 0.0f;   //C stick Y position
   float    trigger       = 0.0f;   //Analog trigger position (max of L or R)
-  uint16_t buttons       = 0;      //Physical buttons pressed
   float    phys_l        = 0.0f;   //Physical L analog value (0-1)
   float    phys_r        = 0.0f;   //Physical R analog value (0-1)
-  uint8_t  ucf_x         = 0;      //Raw UCF value
   float    percent_pre   = 0.0f;   //Percent / damage at the beginning of the frame
 
-  //Post-frame stuff
-  uint8_t  char_id       = 0;      //Internal character ID
-  uint16_t action_post   = 0;      //Action state at the end of the frame
+  //Post-frame floats
   float    pos_x_post    = 0.0f;   //X position at the end of the frame
   float    pos_y_post    = 0.0f;   //Y position at the end of the frame
   float    face_dir_post = 0.0f;   //Facing direction at the end of the frame (-1 = left, +1 = right)
   float    percent_post  = 0.0f;   //Percent / damage at the end of the frame
   float    shield        = 0.0f;   //Shield health (0-60)
+  float    action_fc     = 0.0f;   //Action state frame counter
+  float    hitstun       = 0.0f;   //Hitstun remaining, among other things
+  float    self_air_x    = 0;      //Self-induced aerial X-velocity
+  float    self_air_y    = 0;      //Self-induced aerial Y-velocity
+  float    attack_x      = 0;      //Attack-induced X-velocity
+  float    attack_y      = 0;      //Attack-induced Y-velocity
+  float    self_grd_x    = 0;      //Self-induced grounded X-velocity
+  float    hitlag        = 0;      //Number of hitlag frames remaining
+
+  //32-bit and 16-bit values
+  uint32_t seed          = 0;      //RNG seed at the beginning of the frame
+  uint32_t anim_index    = 0;      //Animation index (used for Wait)
+  uint16_t action_pre    = 0;      //Action state at the beginning of the frame
+  uint16_t buttons       = 0;      //Physical buttons pressed
+  uint16_t action_post   = 0;      //Action state at the end of the frame
+  uint16_t ground_id     = 0;      //ID of the last ground the character stood on
+
+  //Byte values (kept whole, since these are stored exactly as read from the replay)
+  uint8_t  ucf_x         = 0;      //Raw UCF value
+  uint8_t  char_id       = 0;      //Internal character ID
   uint8_t  hit_with      = 0;      //Move ID of this player's last move that connected with an opponent
   uint8_t  combo         = 0;      //In-game combo counter
   uint8_t  hurt_by       = 0;      //Payer ID of the last opponent that hit this player
   uint8_t  stocks        = 0;      //Number of stocks remaining
-  float    action_fc     = 0.0f;   //Action state frame counter
   uint8_t  flags_1       = 0;      //Player state bit flags 1
   uint8_t  flags_2       = 0;      //Player state bit flags 2
   uint8_t  flags_3       = 0;      //Player state bit flags 3
   uint8_t  flags_4       = 0;      //Player state bit flags 4
   uint8_t  flags_5       = 0;      //Player state bit flags 5
-  float    hitstun       = 0.0f;   //Hitstun remaining, among other things
-  bool     airborne      = false;  //Whether the player is airborne
-  uint16_t ground_id     = 0;      //ID of the last ground the character stood on
   uint8_t  jumps         = 0;      //Number of jumps remaining
   uint8_t  l_cancel      = 0;      //L-cancel status (0 = N/A, 1 = success, 2 = failure)
   uint8_t  hurtbox       = 0;      //Hurtbox state (0 = vulnerable, 1 = invulnerable, 2 = intangible)
-  float    self_air_x    = 0;      //Self-induced aerial X-velocity
-  float    self_air_y    = 0;      //Self-induced aerial Y-velocity
-  float    attack_x      = 0;      //Attack-induced X-velocity
-  float    attack_y      = 0;      //Attack-induced Y-velocity
-  float    self_grd_x    = 0;      //Self-induced grounded X-velocity
-  float    hitlag        = 0;      //Number of hitlag frames remaining
-  uint32_t anim_index    = 0;      //Animation index (used for Wait)
+
+  //Single-bit flags (C++17 bitfields can't have initializers, so value-initialize to zero them)
+  bool     alive    : 1;           //For checking if this frame was actually set
+  bool     follower : 1;           //Whether this player is a follower (e.g., 2nd climber)
+  bool     airborne : 1;           //Whether the player is airborne
+};
+static_assert(sizeof(SlippiFrame) == 128, "SlippiFrame should pack into 128 bytes");
+
+//Every per-frame player value field, in SlippiFrame order, as X(type,name)
+#define SLIPPI_FRAME_FIELDS(X) \
+  X(float,pos_x_pre) X(float,pos_y_pre) X(float,face_dir_pre) X(float,joy_x) X(float,joy_y) \
+  X(float,c_x) X(float,c_y) X(float,trigger) X(float,phys_l) X(float,phys_r) X(float,percent_pre) \
+  X(float,pos_x_post) X(float,pos_y_post) X(float,face_dir_post) X(float,percent_post) \
+  X(float,shield) X(float,action_fc) X(float,hitstun) X(float,self_air_x) X(float,self_air_y) \
+  X(float,attack_x) X(float,attack_y) X(float,self_grd_x) X(float,hitlag) \
+  X(uint32_t,seed) X(uint32_t,anim_index) \
+  X(uint16_t,action_pre) X(uint16_t,buttons) X(uint16_t,action_post) X(uint16_t,ground_id) \
+  X(uint8_t,ucf_x) X(uint8_t,char_id) X(uint8_t,hit_with) X(uint8_t,combo) X(uint8_t,hurt_by) \
+  X(uint8_t,stocks) X(uint8_t,flags_1) X(uint8_t,flags_2) X(uint8_t,flags_3) X(uint8_t,flags_4) \
+  X(uint8_t,flags_5) X(uint8_t,jumps) X(uint8_t,l_cancel) X(uint8_t,hurtbox)
+
+//Every per-frame player flag (the SlippiFrame bitfields), as X(name)
+#define SLIPPI_FRAME_FLAGS(X) \
+  X(alive) X(follower) X(airborne)
+
+//One flag per frame, packed eight frames to a byte in the same bit order Arrow uses for
+//  booleans. Frames that share a byte must be written by the same thread.
+struct FrameBits {
+  uint8_t* bits = nullptr;
+  inline bool operator[](uint32_t f) const { return (bits[f >> 3] >> (f & 7)) & 1; }
+  inline void set(uint32_t f, bool on) {
+    bits[f >> 3] = uint8_t((bits[f >> 3] & ~(1 << (f & 7))) | (uint8_t(on) << (f & 7)));
+  }
+};
+
+//Struct-of-arrays frame storage for one player: one contiguous array per SlippiFrame field
+//  and one bit array per flag, indexed by frame (fnum - LOAD_FRAME), all carved from a single
+//  zeroed allocation (from an Arena if one is given, otherwise from the heap)
+struct FrameColumns {
+#define FRAME_COLUMN(type,name) type* name = nullptr;
+  SLIPPI_FRAME_FIELDS(FRAME_COLUMN)
+#undef FRAME_COLUMN
+#define FRAME_FLAG(name) FrameBits name;
+  SLIPPI_FRAME_FLAGS(FRAME_FLAG)
+#undef FRAME_FLAG
+  uint32_t count = 0;        //Number of frames each column holds
+  char*    block = nullptr;  //Backing allocation for all columns
+  Arena*   arena = nullptr;  //Arena block came from (nullptr = heap)
+
+  inline bool empty() const { return block == nullptr; }
+  static size_t bytesFor(uint32_t n);  //Bytes taken by one player's columns for n frames
+  void allocate(uint32_t n, Arena* from = nullptr); //Allocate zeroed columns for n frames
+  void resize(uint32_t n);            //Reallocate columns for n frames, keeping existing frames
+  void release();                     //Free all columns
+  SlippiFrame row(uint32_t f) const;  //Gather a single frame's fields into a SlippiFrame
+};
+
+//Borrowed view of one frame of a player's columns; each field is read from its column
+//  in place, so per-frame predicates work on the columns without gathering a row
+struct FrameView {
+  const FrameColumns& cols;  //Columns being viewed
+  const uint32_t      f;     //Frame index (fnum - LOAD_FRAME)
+#define FRAME_FIELD(type,name) inline type name() const { return cols.name[f]; }
+  SLIPPI_FRAME_FIELDS(FRAME_FIELD)
+#undef FRAME_FIELD
+#define FRAME_FLAG(name) inline bool name() const { return cols.name[f]; }
+  SLIPPI_FRAME_FLAGS(FRAME_FLAG)
+#undef FRAME_FLAG
 };
 
 struct SlippiItemFrame {
@@ -90,15 +165,36 @@ struct SlippiItemFrame {
   int8_t   owner         = 0;  //Port ID of player that owns the item (-1 = unowned)
 };
 
+//A contiguous run of an item's frames; runs are chained so an item can grow without copying
+struct SlippiItemRun {
+  SlippiItemFrame* frame    = nullptr; //Frames in this run (stored right after the run itself)
+  uint32_t         capacity = 0;       //Number of frames this run can hold
+  uint32_t         count    = 0;       //Number of frames used so far
+  SlippiItemRun*   next     = nullptr; //Next run of the item's frames
+};
+
 struct SlippiItem {
-  uint16_t         type       = 0;           //Type of item this is
-  uint32_t         spawn_id   = MAX_ITEMS+1; //ID of this item
-  uint32_t         num_frames = 0;           //Number of frames this item was active
-  SlippiItemFrame* frame      = nullptr;     //Pointer to array of data for item's individual frames
+  uint16_t         type       = 0;       //Type of item this is
+  uint32_t         spawn_id   = 0;       //ID of this item
+  uint32_t         num_frames = 0;       //Number of frames this item was active
+  SlippiItemRun*   first      = nullptr; //First run of the item's frames
+  SlippiItemRun*   last       = nullptr; //Run new frames are appended to
+  SlippiItemFrame& append(Arena* arena); //Add a blank frame (runs come from arena, or the heap if nullptr)
+  const SlippiItemFrame& frame(uint32_t f) const; //The item's f-th frame (walks the runs)
+  void release();                        //Free heap-allocated runs
+};
+
+//Open-addressed map from item spawn IDs to indices into SlippiReplay::items
+struct SlippiItemIndex {
+  std::vector<uint64_t> slots = {}; //(spawn ID << 32) | (index+1) per slot; 0 = empty
+  uint32_t              used  = 0;  //Number of occupied slots
+  int32_t find(uint32_t id) const;  //Index of the item with this spawn ID, or -1
+  void insert(uint32_t id, uint32_t index);
+  void clear();                     //Empty the map, keeping its capacity
 };
 
 struct SlippiFodPlatformFrame {
-  int32_t          frame           = 0;
+  int32_t          frame           = 0;  //Frame index (0 == internal frame -123)
   float            left_height     = 0;  //Left platform height for this frame
   float            right_height    = 0;  //Right platform height for this frame
 };
@@ -131,7 +227,7 @@ struct SlippiPlayer {
   std::string  tag_css      = "";      //Player tag entered on character select screen
   std::string  disp_name    = "";      //Display name used on Slippi Online
   std::string  slippi_uid   = "";      //Firebase UID of Slippi player
-  SlippiFrame* frame        = nullptr; //Pointer to array of data for player's individual frames
+  FrameColumns cols         = {};      //Columnar data for player's individual frames (filled by the parser)
 };
 
 struct SlippiReplay {
@@ -160,6 +256,9 @@ struct SlippiReplay {
   int32_t         first_frame         = LOAD_FRAME; //Index of first frame of the game (always -123)
   int32_t         last_frame          = 0;          //Index of the last frame of the game
   uint32_t        frame_count         = 0;          //Total number of frames the game lasted (always == last_frame+123)
+  uint32_t        rollbacks           = 0;          //Number of times the game rolled back to an earlier frame
+  uint32_t        rollback_frames     = 0;          //Number of frames re-simulated (and so superseded) by rollbacks
+  uint32_t        rollback_longest    = 0;          //Most frames re-simulated by a single rollback
   uint8_t         timer               = 0;          //Number of minutes the timer started at
   int8_t          items_on            = 0;          //Item spawn rate (-1 = disabled, 0 = very low, 1 = low, etc.)
   int8_t          sd_score            = 0;          //How many points a player loses for SDing
@@ -188,19 +287,80 @@ struct SlippiReplay {
   uint8_t         items4              = 0;          //Item enabled / disabled bitfield 4
   uint8_t         items5              = 0;          //Item enabled / disabled bitfield 5
   bool            sudden_death        = false;      //Whether bombs start dropping after 20 seconds
-  uint32_t        num_items           = 0;          //Number of distinct item IDs encountered during the game
+  uint32_t        num_items           = 0;          //Number of distinct items encountered during the game
   uint8_t         language            = 0;          //Language option (0 = Japanese, 1 = English)
   SlippiPlayer    player[8]           = {};         //Array of SlippiPlayers (1 main + follower for each port)
-  SlippiItem      item[MAX_ITEMS]     = {};         //Array of SlippiItems (can track up to MAX_ITEMS per game)
-  std::vector<SlippiFodPlatformFrame> platform_frames = {};//Array of SlippiFodPlatformFrame for every frame when stage = 2 (Fountain of Dreams)
-  void setFrames(int32_t max_frames);
+  std::vector<SlippiItem> items       = {};         //Every item seen, in the order it first appeared
+  SlippiItemIndex item_index          = {};         //Lookup from spawn ID into items
+  std::vector<SlippiFodPlatformFrame> platform_changes = {};//Frames where a Fountain of Dreams platform moved (sorted; heights hold until the next change)
+  Arena*          arena               = nullptr;    //Where frame storage comes from (nullptr = heap)
+  SlippiReplay() = default;
+  SlippiReplay(const SlippiReplay&) = delete;  //Replays are read through a ReplayView, never copied
+  SlippiReplay& operator=(const SlippiReplay&) = delete;
+  SlippiReplay(SlippiReplay&&) = default;
+  SlippiReplay& operator=(SlippiReplay&&) = default;
+  void setFrames(int32_t max_frames, uint8_t followers = 0x0F);
+  void growFrames(int32_t old_max_frames, int32_t new_max_frames);
   void cleanup();
-  arrow::Status playerFramesAsParquet();
-  arrow::Status itemFramesAsParquet();
-  arrow::Status fodPlatformFramesAsParquet();
+  void setPlatformHeight(int32_t f, uint8_t platform, float height); //Record a FoD platform move at frame index f
+  SlippiFodPlatformFrame platformsAt(int32_t f) const;               //FoD platform heights at frame index f
+  arrow::Status playerFramesAsParquet(const OutputSink& sink, const ParquetOptions& o = ParquetOptions());
+  arrow::Status playerFramesAsParquet(ParquetAppender& out);      //Append to a shared file
+  arrow::Status itemFramesAsParquet(const OutputSink& sink, const ParquetOptions& o = ParquetOptions());
+  arrow::Status itemFramesAsParquet(ParquetAppender& out);        //Append to a shared file
+  arrow::Status fodPlatformFramesAsParquet(const OutputSink& sink, const ParquetOptions& o = ParquetOptions());
+  arrow::Status fodPlatformFramesAsParquet(ParquetAppender& out); //Append to a shared file
   std::string settingsAsJson();
   std::string matchSettingsAsJson(const std::string& filename);
   std::string playerSettingsAsJson();
+  std::string partition() const;  //Hive partition for this replay's files: stage=<id>/date=<yyyy-mm-dd>/chars=<ids>
+};
+
+//Borrowed, read-only view of one player: settings plus frame storage, by reference
+struct PlayerView {
+  const SlippiPlayer& info;   //Settings and metadata for the player
+  const FrameColumns& cols;   //Columnar frame data
+  explicit PlayerView(const SlippiPlayer& p) : info(p), cols(p.cols) {}
+  inline FrameView frame(uint32_t f) const { return FrameView{cols,f}; }  //Frame f (fnum - LOAD_FRAME), read from the columns
+};
+
+//Borrowed, read-only view of a replay; the writers and analyzer read through
+//  one of these so that looking at a replay never copies it
+struct ReplayView {
+  const SlippiReplay& replay;  //Replay being viewed (must outlive the view)
+  ReplayView(const SlippiReplay& r) : replay(r) {}
+  inline PlayerView player(unsigned p) const { return PlayerView(replay.player[p]); }
+  inline const SlippiReplay* operator->() const { return &replay; }
+};
+
+//Writes player frames to Parquet one row group at a time. Frames are handed over as
+//  soon as they're final, and each row group wraps the parser's frame columns in place
+//  (they must stay alive until the row group is written), so the writer's memory is
+//  bounded by the row group size rather than the game length. Each row group holds
+//  the same range of frames for every player.
+class PlayerFrameWriter {
+private:
+  struct Columns;                             //Arrow arrays for one row group (defined in replay.cpp)
+  std::unique_ptr<Columns>         _columns;  //Row group state (kept from one replay to the next)
+  std::unique_ptr<ParquetAppender> _own;      //File of our own, when opened with a sink
+  ParquetAppender* _out            = nullptr; //Where row groups are written (nullptr when not open)
+  uint32_t         _row_group_rows = 0;       //Rows to buffer before writing a row group
+  uint32_t         _written        = 0;       //Frames (per player) already written
+  uint32_t         _row_groups     = 0;       //Row groups written so far
+  uint32_t         _peak_rows      = 0;       //Most rows in a single row group
+  bool             _sorted         = false;   //Whether rows are written player by player (at close())
+  arrow::Status _writeRows(const ReplayView& s, uint32_t frames, int player = -1); //Copy frames [_written,frames) (of one player, or all) into one row group
+public:
+  PlayerFrameWriter();
+  ~PlayerFrameWriter();
+  arrow::Status open(const OutputSink& sink, const ParquetOptions& o = ParquetOptions()); //Start frames.parquet in the sink
+  arrow::Status open(ParquetAppender& out);                    //Append this replay's frames to a shared file instead
+  arrow::Status write(const SlippiReplay& r, uint32_t frames); //Frames [0,frames) are final; write any full row groups
+  arrow::Status close(const SlippiReplay& r);                  //Write the remaining frames and finish the file
+  inline bool     isOpen()    const { return _out != nullptr; }
+  inline uint32_t written()   const { return _written; }    //Frames (per player) written so far
+  inline uint32_t rowGroups() const { return _row_groups; } //Row groups written so far
+  inline uint32_t peakRows()  const { return _peak_rows; }  //Most rows in a single row group
 };
 
 }
@@ -1,4 +1,5 @@
 #include "tests.h"
+#include <arrow/io/memory.h>
 
 // file containing test replays
 static const std::string TESTDIR       = "test-replays";
@@ -9,6 +10,11 @@ static const std::string CORRUPTDIR    = "corrupt";
 // replays that were compressed with old versions of compressor
 
 
+// scratch directory for command line tests (kept out of the temp directory)
+static const std::string CLIDIR        = "cli-replays";
+// slippc binary for command line tests
+static const std::string SLIPPC        = "./slippc";
+
 // known file 1
 static const std::string TSLPFILE      = "3-9-0-singles-irl-summit12.slp.xz";
 // known file 2
@@ -22,6 +28,62 @@ typedef std::filesystem::directory_entry    f_entry;
 
 static int _debug = 0;
 
+//Heap allocation tracking for testNoReplayCopies(): records the size of every allocation while armed.
+//  Every replaceable operator new / delete (array, aligned, and nothrow forms included) goes
+//  through the two functions below, so no allocation escapes the count. They're kept out of
+//  line so the compiler never sees free() paired directly with a new-expression.
+static bool     __track_allocs = false;
+static size_t   __alloc_sizes[1 << 16];
+static unsigned __alloc_count  = 0;
+
+[[gnu::noinline]] static void* trackedAlloc(size_t n, size_t align) {
+  if (__track_allocs && __alloc_count < (1 << 16)) {
+    __alloc_sizes[__alloc_count++] = n;
+  }
+  //Over-allocate, and keep malloc()'s pointer just before the aligned block
+  align       = std::max(align,alignof(void*));
+  void* raw   = malloc(n + align + sizeof(void*));
+  if (raw == nullptr) {
+    return nullptr;
+  }
+  uintptr_t at = (uintptr_t(raw) + sizeof(void*) + align - 1) & ~uintptr_t(align - 1);
+  reinterpret_cast<void**>(at)[-1] = raw;
+  return reinterpret_cast<void*>(at);
+}
+[[gnu::noinline]] static void trackedFree(void* p) {
+  if (p != nullptr) {
+    free(reinterpret_cast<void**>(p)[-1]);
+  }
+}
+static inline void* trackedNew(size_t n, size_t align) {
+  void* p = trackedAlloc(n,align);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void* operator new  (size_t n)                                           { return trackedNew(n,__STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void* operator new[](size_t n)                                           { return trackedNew(n,__STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void* operator new  (size_t n, std::align_val_t a)                       { return trackedNew(n,size_t(a)); }
+void* operator new[](size_t n, std::align_val_t a)                       { return trackedNew(n,size_t(a)); }
+void* operator new  (size_t n, const std::nothrow_t&) noexcept           { return trackedAlloc(n,__STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void* operator new[](size_t n, const std::nothrow_t&) noexcept           { return trackedAlloc(n,__STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void* operator new  (size_t n, std::align_val_t a, const std::nothrow_t&) noexcept { return trackedAlloc(n,size_t(a)); }
+void* operator new[](size_t n, std::align_val_t a, const std::nothrow_t&) noexcept { return trackedAlloc(n,size_t(a)); }
+void operator delete  (void* p) noexcept                                         { trackedFree(p); }
+void operator delete[](void* p) noexcept                                         { trackedFree(p); }
+void operator delete  (void* p, size_t) noexcept                                 { trackedFree(p); }
+void operator delete[](void* p, size_t) noexcept                                 { trackedFree(p); }
+void operator delete  (void* p, std::align_val_t) noexcept                       { trackedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept                       { trackedFree(p); }
+void operator delete  (void* p, size_t, std::align_val_t) noexcept               { trackedFree(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept               { trackedFree(p); }
+void operator delete  (void* p, const std::nothrow_t&) noexcept                  { trackedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept                  { trackedFree(p); }
+void operator delete  (void* p, std::align_val_t, const std::nothrow_t&) noexcept { trackedFree(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { trackedFree(p); }
+
 namespace slip {
 
 // https://stackoverflow.com/questions/865668/how-to-parse-command-line-arguments-in-c
@@ -128,6 +190,9 @@ int sanityCheck(slip::Parser *p, std::string name, std::string path) {
   ASSERT("  Game has at least 1 player",playing >= 0,
     "Game has no players");
   BAILONFAIL(1);
+  ASSERT("  Rollback stats are consistent",
+    r->rollback_frames >= r->rollbacks && r->rollback_longest <= r->rollback_frames && r->rollback_frames < r->frame_count,
+    r->rollbacks << " rollbacks, " << r->rollback_frames << " frames, longest " << r->rollback_longest);
 
   for(unsigned pnum = 0; pnum < 8; ++pnum) {
     if (r->player[pnum].player_type == 3) {
@@ -135,10 +200,10 @@ int sanityCheck(slip::Parser *p, std::string name, std::string path) {
     }
     unsigned flag_char = 0, flag_jumps = 0, flag_dmg = 0, flag_shield = 0,
       flag_lcancel = 0, flag_hurt = 0, flag_stocks = 0, flag_stocks_inc = 0;
-    unsigned char cid = r->player[pnum].frame[0].char_id;
+    unsigned char cid = r->player[pnum].cols.char_id[0];
     bool sheik = ((cid == 7) || (cid == 19));
     for(unsigned f = 1; f < r->frame_count; ++f) {
-      SlippiFrame sf = r->player[pnum].frame[f];
+      SlippiFrame sf = r->player[pnum].cols.row(f);
       if (sf.action_post > Action::Sleep) {  //if we're not dead
         if (sf.char_id != cid) {
           if(!(sheik && (sf.char_id == 7 || sf.char_id == 19))) {
@@ -218,6 +283,1012 @@ int testConsistencySanity() {
 }
 
 
+//Field-by-field comparison (SlippiFrame has padding, so memcmp won't do)
+bool framesMatch(const SlippiFrame &a, const SlippiFrame &b) {
+  #define SAME(x) (a.x == b.x)
+  return SAME(alive) && SAME(follower) && SAME(seed)
+    && SAME(action_pre) && SAME(pos_x_pre) && SAME(pos_y_pre) && SAME(face_dir_pre)
+    && SAME(joy_x) && SAME(joy_y) && SAME(c_x) && SAME(c_y) && SAME(trigger)
+    && SAME(buttons) && SAME(phys_l) && SAME(phys_r) && SAME(ucf_x) && SAME(percent_pre)
+    && SAME(char_id) && SAME(action_post) && SAME(pos_x_post) && SAME(pos_y_post)
+    && SAME(face_dir_post) && SAME(percent_post) && SAME(shield) && SAME(hit_with)
+    && SAME(combo) && SAME(hurt_by) && SAME(stocks) && SAME(action_fc)
+    && SAME(flags_1) && SAME(flags_2) && SAME(flags_3) && SAME(flags_4) && SAME(flags_5)
+    && SAME(hitstun) && SAME(airborne) && SAME(ground_id) && SAME(jumps) && SAME(l_cancel)
+    && SAME(hurtbox) && SAME(self_air_x) && SAME(self_air_y) && SAME(attack_x)
+    && SAME(attack_y) && SAME(self_grd_x) && SAME(hitlag) && SAME(anim_index);
+  #undef SAME
+}
+
+bool framesMatch(const FrameView &a, const SlippiFrame &b) {
+  #define SAME(type,x) && (a.x() == b.x)
+  #define SAME_FLAG(x) && (a.x() == b.x)
+  return true SLIPPI_FRAME_FIELDS(SAME) SLIPPI_FRAME_FLAGS(SAME_FLAG);
+  #undef SAME_FLAG
+  #undef SAME
+}
+
+int testBufferLoading() {
+  TSUITE("Loading From Memory");
+    for (const f_entry & entry : f_iter(PATH(TESTDIR) / PATH(STANDARDDIR))) {
+      std::string path = entry.path().string();
+      std::string name = entry.path().stem().string();
+
+      std::ifstream in(path, std::ios::binary);
+      std::vector<char> buf((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+      slip::Parser *pf = new slip::Parser(_debug);
+      slip::Parser *pb = new slip::Parser(_debug);
+      bool lf = pf->load(path.c_str());
+      bool lb = pb->loadFromBuffer(buf.data(), buf.size(), path.c_str());
+      ASSERT(name+" parses identically from file and memory",lf == lb,
+        name << " parses from " << (lf ? "file" : "memory") << " only");
+      if (lf && lb) {
+        const SlippiReplay* rf = pf->replay();
+        const SlippiReplay* rb = pb->replay();
+        ASSERT("  Frame counts match",rf->frame_count == rb->frame_count,
+          rf->frame_count << " != " << rb->frame_count);
+        ASSERT("  Settings match",pf->settingsAsJson().compare(pb->settingsAsJson()) == 0,
+          "Settings JSON differs");
+        unsigned mismatches = 0;
+        for(unsigned pnum = 0; pnum < 8 && rf->frame_count == rb->frame_count; ++pnum) {
+          if (rf->player[pnum].cols.empty()) {
+            continue;
+          }
+          for(unsigned f = 0; f < rf->frame_count; ++f) {
+            if (!framesMatch(rf->player[pnum].cols.row(f),rb->player[pnum].cols.row(f))) {
+              ++mismatches;
+            }
+          }
+        }
+        ASSERT("  Frame data matches",mismatches == 0,
+          mismatches << " frames differ");
+      }
+      delete pf;
+      delete pb;
+    };
+  return 0;
+}
+
+int testParallelDecoding() {
+  TSUITE("Parallel Frame Decoding");
+    for (const f_entry & entry : f_iter(PATH(TESTDIR) / PATH(STANDARDDIR))) {
+      std::string path = entry.path().string();
+      std::string name = entry.path().stem().string();
+
+      slip::Parser *ps = new slip::Parser(_debug);
+      slip::Parser *pp = new slip::Parser(_debug);
+      pp->setThreads(4);
+      bool ls = ps->load(path.c_str());
+      bool lp = pp->load(path.c_str());
+      ASSERT(name+" parses identically with one and four threads",ls == lp,
+        name << " parses with " << (ls ? "one" : "four") << " thread(s) only");
+      if (ls && lp) {
+        const SlippiReplay* rs = ps->replay();
+        const SlippiReplay* rp = pp->replay();
+        ASSERT("  Frame counts match",rs->frame_count == rp->frame_count,
+          rs->frame_count << " != " << rp->frame_count);
+        ASSERT("  Winners and errors match",rs->winner_id == rp->winner_id && rs->errors == rp->errors,
+          "winner " << +rs->winner_id << " vs " << +rp->winner_id << ", errors " << rs->errors << " vs " << rp->errors);
+        unsigned mismatches = 0;
+        for(unsigned pnum = 0; pnum < 8 && rs->frame_count == rp->frame_count; ++pnum) {
+          if (rs->player[pnum].cols.empty()) {
+            continue;
+          }
+          for(unsigned f = 0; f < rs->frame_count; ++f) {
+            if (!framesMatch(rs->player[pnum].cols.row(f),rp->player[pnum].cols.row(f))) {
+              ++mismatches;
+            }
+          }
+        }
+        ASSERT("  Frame data matches",mismatches == 0,
+          mismatches << " frames differ");
+      }
+      delete ps;
+      delete pp;
+    };
+  return 0;
+}
+
+int testExactSizing() {
+  TSUITE("Exact Frame Sizing");
+    for (const f_entry & entry : f_iter(PATH(TESTDIR) / PATH(STANDARDDIR))) {
+      std::string path = entry.path().string();
+      std::string name = entry.path().stem().string();
+
+      slip::Parser *px = new slip::Parser(_debug);
+      slip::Parser *pe = new slip::Parser(_debug);
+      pe->setExactSizing(false);
+      if (!(px->load(path.c_str()) && pe->load(path.c_str()))) {
+        delete px;
+        delete pe;
+        continue;  //Covered by the sanity checks
+      }
+      const SlippiReplay* rx = px->replay();
+      const SlippiReplay* re = pe->replay();
+      ASSERT(name+" frame count matches estimated sizing",rx->frame_count == re->frame_count,
+        rx->frame_count << " != " << re->frame_count);
+      unsigned mismatches = 0;
+      for(unsigned pnum = 0; pnum < 8 && rx->frame_count == re->frame_count; ++pnum) {
+        if (rx->player[pnum].cols.empty()) {
+          continue;
+        }
+        for(unsigned f = 0; f < rx->frame_count; ++f) {
+          if (!framesMatch(rx->player[pnum].cols.row(f),re->player[pnum].cols.row(f))) {
+            ++mismatches;
+          }
+        }
+      }
+      ASSERT("  Frame data matches",mismatches == 0,
+        mismatches << " frames differ");
+      if (rx->stage == 2) {
+        unsigned plat_mismatches = 0;
+        for(unsigned f = 0; f < rx->frame_count; ++f) {
+          SlippiFodPlatformFrame hx = rx->platformsAt(f), he = re->platformsAt(f);
+          plat_mismatches += (hx.left_height != he.left_height) || (hx.right_height != he.right_height);
+        }
+        ASSERT("  FoD platform heights match",plat_mismatches == 0,
+          plat_mismatches << " frames differ");
+      }
+      delete px;
+      delete pe;
+    };
+  return 0;
+}
+
+int testFrameColumns() {
+  TSUITE("Columnar Frame Store");
+    //Frame numbers and ports follow from where a frame is stored, and flags take a bit each
+    const uint32_t n = 1 << 16;
+    size_t per_frame = 0;
+    #define FIELD_BYTES(type,name) per_frame += sizeof(type);
+    SLIPPI_FRAME_FIELDS(FIELD_BYTES)
+    #undef FIELD_BYTES
+    ASSERT("Columns take 126 bytes and 3 bits per frame",per_frame == 126 && FrameColumns::bytesFor(n) == n*per_frame + 3*n/8,
+      per_frame << " bytes of fields; " << FrameColumns::bytesFor(n) << " bytes for " << n << " frames");
+    ASSERT("  Rows pack into 128 bytes",sizeof(SlippiFrame) == 128,
+      "SlippiFrame is " << sizeof(SlippiFrame) << " bytes");
+
+    for (const f_entry & entry : f_iter(PATH(TESTDIR) / PATH(STANDARDDIR))) {
+      std::string path = entry.path().string();
+      std::string name = entry.path().stem().string();
+
+      slip::Parser *p = new slip::Parser(_debug);
+      if (!p->load(path.c_str())) {
+        delete p;
+        continue;  //Covered by the sanity checks
+      }
+      const SlippiReplay* r = p->replay();
+      unsigned mismatches = 0, misaligned = 0;
+      for(unsigned pnum = 0; pnum < 8; ++pnum) {
+        if (r->player[pnum].cols.empty()) {
+          continue;
+        }
+        const PlayerView pv(r->player[pnum]);
+        misaligned += (uintptr_t(r->player[pnum].cols.pos_x_pre) % 64 != 0);
+        misaligned += (uintptr_t(r->player[pnum].cols.action_post) % 64 != 0);
+        for(unsigned f = 0; f < r->frame_count; ++f) {
+          if (!framesMatch(pv.frame(f),r->player[pnum].cols.row(f))) {
+            ++mismatches;
+          }
+        }
+      }
+      ASSERT(name+" columns start on cache lines",misaligned == 0,
+        misaligned << " columns are misaligned");
+      ASSERT("  Frame views match gathered rows",mismatches == 0,
+        mismatches << " frames differ");
+      delete p;
+    };
+  return 0;
+}
+
+int testArenaReuse() {
+  TSUITE("Reusing a Parser");
+    slip::Parser *pr = new slip::Parser(_debug);
+    unsigned mismatches = 0, loads = 0;
+    for (const f_entry & entry : f_iter(PATH(TESTDIR) / PATH(STANDARDDIR))) {
+      std::string path = entry.path().string();
+      slip::Parser *pf = new slip::Parser(_debug);
+      bool lf = pf->load(path.c_str());
+      bool lr = pr->load(path.c_str());
+      if (lf != lr) {
+        ++mismatches;
+      } else if (lf) {
+        ++loads;
+        const SlippiReplay* rf = pf->replay();
+        const SlippiReplay* rr = pr->replay();
+        mismatches += (rf->frame_count != rr->frame_count) || (rf->errors != rr->errors)
+          || (rf->winner_id != rr->winner_id) || (pf->settingsAsJson().compare(pr->settingsAsJson()) != 0);
+        for(unsigned pnum = 0; pnum < 8 && rf->frame_count == rr->frame_count; ++pnum) {
+          if (rf->player[pnum].cols.empty() != rr->player[pnum].cols.empty()) {
+            ++mismatches;
+            continue;
+          }
+          for(unsigned f = 0; f < rf->frame_count && !rf->player[pnum].cols.empty(); ++f) {
+            mismatches += !framesMatch(rf->player[pnum].cols.row(f),rr->player[pnum].cols.row(f));
+          }
+        }
+      }
+      delete pf;
+    }
+    ASSERT("Replays load into a reused parser as into a fresh one",mismatches == 0,
+      mismatches << " differences across " << loads << " replays");
+
+    //Once the arena has been reset after the largest replay, it never needs the heap again
+    unsigned chunks = 0;
+    for (unsigned pass = 0; pass < 2; ++pass) {
+      chunks = pr->arena()->heapAllocations();
+      for (const f_entry & entry : f_iter(PATH(TESTDIR) / PATH(STANDARDDIR))) {
+        pr->load(entry.path().string().c_str());
+      }
+    }
+    ASSERT("  No new frame storage in steady state",pr->arena()->heapAllocations() == chunks,
+      (pr->arena()->heapAllocations()-chunks) << " chunks allocated on the second pass");
+    delete pr;
+  return 0;
+}
+
+int testItemTracking() {
+  TSUITE("Item Tracking");
+    //Items live as long as they like, in runs that grow with them
+    Arena arena;
+    SlippiItem item;
+    for (int32_t f = 0; f < 3000; ++f) {
+      item.append(&arena).frame = f;
+    }
+    unsigned runs = 0, ordered = 1;
+    for (const SlippiItemRun* run = item.first; run != nullptr; run = run->next) {
+      ++runs;
+    }
+    for (uint32_t f = 0; f < item.num_frames; ++f) {
+      ordered &= (item.frame(f).frame == int32_t(f));
+    }
+    ASSERT("Long-lived items keep every frame",item.num_frames == 3000 && ordered,
+      item.num_frames << " frames kept of 3000");
+    ASSERT("  Frames are stored in a few growing runs",runs <= 8,
+      "3000 frames took " << runs << " runs");
+
+    //Spawn IDs aren't bounded, and needn't be dense
+    SlippiItemIndex index;
+    unsigned misses = 0;
+    for (uint32_t id = 0; id < 5000; ++id) {
+      index.insert(id*7,id);
+    }
+    index.insert(3039053192u,5000);
+    for (uint32_t id = 0; id < 5000; ++id) {
+      misses += (index.find(id*7) != int32_t(id)) + (index.find(id*7+1) != -1);
+    }
+    ASSERT("  Item IDs map to their items",misses == 0 && index.find(3039053192u) == 5000,
+      misses << " lookups failed");
+
+    for (const f_entry & entry : f_iter(PATH(TESTDIR) / PATH(STANDARDDIR))) {
+      std::string path = entry.path().string();
+      std::string name = entry.path().stem().string();
+      slip::Parser *p = new slip::Parser(_debug);
+      if (!p->load(path.c_str())) {
+        delete p;
+        continue;  //Covered by the sanity checks
+      }
+      const SlippiReplay* r = p->replay();
+      unsigned bad = 0;
+      for (unsigned i = 0; i < r->items.size(); ++i) {
+        uint32_t frames = 0;
+        for (const SlippiItemRun* run = r->items[i].first; run != nullptr; run = run->next) {
+          frames += run->count;
+        }
+        bad += (frames != r->items[i].num_frames) || (r->item_index.find(r->items[i].spawn_id) != int32_t(i));
+      }
+      ASSERT(name+" items are indexed and complete",bad == 0 && r->num_items == r->items.size(),
+        bad << " of " << r->items.size() << " items are inconsistent");
+      delete p;
+    }
+  return 0;
+}
+
+int testAnalysisReuse() {
+  TSUITE("Reusing an Analysis");
+    slip::Parser   pr(_debug);
+    slip::Analysis ar(0);
+    unsigned mismatches = 0, analyses = 0, leftovers = 0;
+    const unsigned* dynamics = nullptr;
+    bool reallocated = false;
+    for (unsigned pass = 0; pass < 2; ++pass) {  //Second pass analyzes every replay after some other one
+      for (const f_entry & entry : f_iter(PATH(TESTDIR) / PATH(STANDARDDIR))) {
+        std::string path = entry.path().string();
+        slip::Parser *pf = new slip::Parser(_debug);
+        if (!pf->load(path.c_str()) || !pr.load(path.c_str())) {
+          delete pf;
+          continue;  //Covered by the sanity checks
+        }
+        Analysis* af = pf->analyze();
+        bool ok      = pr.analyze(ar);
+        mismatches  += (ok != af->success) || (ar.asJson().compare(af->asJson()) != 0);
+        reallocated |= (pass > 0 && ar.dynamics != dynamics);
+        dynamics     = ar.dynamics;
+        ++analyses;
+        delete af;
+        delete pf;
+
+        pr.reset();
+        leftovers += (pr.replay()->frame_count != 0) || !pr.replay()->player[0].cols.empty();
+      }
+    }
+    ASSERT("Analyses into a reused Analysis match fresh ones",mismatches == 0,
+      mismatches << " differences across " << analyses << " analyses");
+    ASSERT("  Per-frame storage is kept between analyses",!reallocated,
+      "dynamics were reallocated on the second pass");
+    ASSERT("  Parser::reset() drops the loaded replay",leftovers == 0,
+      leftovers << " replays still loaded after reset");
+  return 0;
+}
+
+int testAttackPunishLists() {
+  TSUITE("Attack and Punish Lists");
+    Analysis empty(0);
+    ASSERT("A new analysis starts with no attack or punish storage",
+      empty.ap[0].attacks.capacity() == 0 && empty.ap[0].punishes.capacity() == 0,
+      empty.ap[0].attacks.capacity() << " attacks and " << empty.ap[0].punishes.capacity() << " punishes reserved");
+    for (const f_entry & entry : f_iter(PATH(TESTDIR) / PATH(STANDARDDIR))) {
+      std::string path = entry.path().string();
+      std::string name = entry.path().stem().string();
+      slip::Parser *p = new slip::Parser(_debug);
+      if (!p->load(path.c_str())) {
+        delete p;
+        continue;  //Covered by the sanity checks
+      }
+      Analysis* a = p->analyze();
+      unsigned bad = 0, hits = 0, moves = 0;
+      for(unsigned pi = 0; pi < 2; ++pi) {
+        const AnalysisPlayer& ap = a->ap[pi];
+        for(unsigned i = 0; i < ap.attacks.size(); ++i) {
+          bad += (ap.attacks[i].frame == 0) || (ap.attacks[i].punish_id >= ap.punishes.size())
+            || (i > 0 && ap.attacks[i].frame < ap.attacks[i-1].frame);
+        }
+        for(const Punish& pu : ap.punishes) {
+          bad   += (pu.num_moves == 0) || (pu.end_frame < pu.start_frame);
+          moves += pu.num_moves;
+        }
+        hits += ap.attacks.size();
+      }
+      ASSERT(name+" attacks and punishes are consistent",bad == 0,
+        bad << " malformed attacks / punishes");
+      ASSERT("  Every attack belongs to a punish",moves == hits,
+        hits << " attacks but " << moves << " punish moves");
+      delete a;
+      delete p;
+    }
+  return 0;
+}
+
+int testDynamicIntervals() {
+  TSUITE("Dynamic Intervals");
+    for (const f_entry & entry : f_iter(PATH(TESTDIR) / PATH(STANDARDDIR))) {
+      std::string path = entry.path().string();
+      std::string name = entry.path().stem().string();
+      slip::Parser *p = new slip::Parser(_debug);
+      if (!p->load(path.c_str())) {
+        delete p;
+        continue;  //Covered by the sanity checks
+      }
+      Analysis* a = p->analyze();
+      const std::vector<DynamicInterval>& di = a->dyn_intervals;
+      unsigned frames = p->replay()->frame_count;
+      unsigned gaps = 0, merged = 0, mismatches = 0;
+      for(unsigned i = 0; i < di.size(); ++i) {
+        gaps   += (di[i].start >= di[i].end) || (di[i].start != (i == 0 ? FIRST_FRAME : di[i-1].end));
+        merged += (i > 0 && di[i].dynamic == di[i-1].dynamic);
+      }
+      for(unsigned f = FIRST_FRAME; f < frames; ++f) {
+        mismatches += (a->dynamicAt(f) != a->dynamics[f]);
+      }
+      ASSERT(name+" intervals tile the analyzed frames",gaps == 0 && !di.empty() && di.back().end == frames,
+        gaps << " gaps or overlaps; last interval ends at " << (di.empty() ? 0 : di.back().end) << " of " << frames);
+      ASSERT("  Adjacent intervals have different dynamics",merged == 0,
+        merged << " intervals could have been merged");
+      ASSERT("  Intervals agree with per-frame dynamics",mismatches == 0,
+        mismatches << " frames differ");
+      ASSERT("  Intervals are much fewer than frames",di.size()*10 < frames,
+        di.size() << " intervals for " << frames << " frames");
+
+      //Counts and per-player rows from intervals must match counting frame by frame
+      //  (the 2nd player sees non-neutral dynamics inverted)
+      std::vector<unsigned> counted[2], rows[2];
+      for(unsigned pl = 0; pl < 2; ++pl) {
+        counted[pl].assign(Dynamic::__LAST+1,0);
+        rows[pl].assign(Dynamic::__LAST+1,0);
+      }
+      for(unsigned f = FIRST_FRAME; f < frames; ++f) {
+        unsigned d = a->dynamics[f];
+        ++counted[0][d];
+        ++counted[1][(d > Dynamic::DEFENSIVE && d < Dynamic::OFFENSIVE) ? d : Dynamic::__LAST - d];
+      }
+      for(unsigned pl = 0; pl < 2; ++pl) {
+        for(const DynamicInterval& i : di) {
+          rows[pl][Analysis::dynamicFor(i.dynamic,pl)] += i.end - i.start;  //As written to the dynamics table
+        }
+      }
+      unsigned wrong_counts = 0, wrong_rows = 0;
+      for(unsigned pl = 0; pl < 2; ++pl) {
+        for(unsigned d = 0; d < Dynamic::__LAST; ++d) {
+          wrong_counts += (a->ap[pl].dyn_counts[d] != counted[pl][d]);
+          wrong_rows   += (rows[pl][d] != counted[pl][d]);
+        }
+        wrong_counts += (counted[pl][Dynamic::__LAST] != 0);
+      }
+      ASSERT("  Dynamic counts match per-frame counting",wrong_counts == 0,
+        wrong_counts << " counts differ");
+      ASSERT("  Per-player interval rows match per-frame counting",wrong_rows == 0,
+        wrong_rows << " dynamics differ");
+      delete a;
+      delete p;
+    }
+  return 0;
+}
+
+int testPlatformChanges() {
+  TSUITE("FoD Platform Changes");
+    //Moves recorded out of order must give the same heights as filling a per-frame table
+    SlippiReplay r;
+    const unsigned frames = 200;
+    std::vector<float> left(frames,FOD_LEFT_HEIGHT), right(frames,FOD_RIGHT_HEIGHT);
+    const int32_t moves[][3] = {{50,1,18},{10,0,30},{120,1,12},{50,0,25},{90,2,99},{10,1,19}};
+    for (const auto& m : moves) {
+      r.setPlatformHeight(m[0],m[1],m[2]);
+      for(unsigned f = m[0]; m[1] <= 1 && f < frames; ++f) {
+        (m[1] == 0 ? right[f] : left[f]) = m[2];
+      }
+    }
+    unsigned mismatches = 0;
+    for(unsigned f = 0; f < frames; ++f) {
+      SlippiFodPlatformFrame h = r.platformsAt(f);
+      mismatches += (h.left_height != left[f]) || (h.right_height != right[f]);
+    }
+    ASSERT("Out-of-order moves match a filled table",mismatches == 0,
+      mismatches << " frames differ");
+    ASSERT("  One change per distinct frame",r.platform_changes.size() == 3,
+      r.platform_changes.size() << " changes recorded");
+
+    for (const f_entry & entry : f_iter(PATH(TESTDIR) / PATH(STANDARDDIR))) {
+      std::string path = entry.path().string();
+      std::string name = entry.path().stem().string();
+      slip::Parser *p = new slip::Parser(_debug);
+      if (!p->load(path.c_str()) || p->replay()->stage != 2) {
+        delete p;
+        continue;  //Only Fountain of Dreams has moving platforms
+      }
+      const std::vector<SlippiFodPlatformFrame>& pc = p->replay()->platform_changes;
+      unsigned unsorted = 0;
+      for(unsigned i = 1; i < pc.size(); ++i) {
+        unsorted += (pc[i].frame <= pc[i-1].frame);
+      }
+      ASSERT(name+" platform changes are sorted",unsorted == 0,
+        unsorted << " changes out of order");
+      ASSERT("  Changes are fewer than frames",pc.size() < p->replay()->frame_count,
+        pc.size() << " changes for " << p->replay()->frame_count << " frames");
+      delete p;
+    }
+  return 0;
+}
+
+int testParquetOptions() {
+  TSUITE("Parquet Options");
+    ParquetOptions o;
+    ASSERT("Defaults to snappy",o.codec == "snappy" && o.row_group_rows == PARQUET_ROW_GROUP_ROWS,
+      o.codec << " with " << o.row_group_rows << " rows per row group");
+    ASSERT("Codec levels are parsed",o.setCodec("zstd:7") && o.codec == "zstd" && o.level == 7,
+      o.codec << ":" << o.level);
+    ASSERT("Unknown codecs are rejected",!o.setCodec("lzma") && o.codec == "zstd",
+      "codec is now " << o.codec);
+    ASSERT("Malformed levels are rejected",!o.setCodec("zstd:abc") && !o.setCodec("zstd:") && !o.setCodec("zstd:5x")
+      && o.codec == "zstd" && o.level == 7,"codec is now " << o.codec << ":" << o.level);
+    ASSERT("Levels are rejected for codecs without them",!o.setCodec("snappy:3") && !o.setCodec("lz4:1")
+      && !o.setCodec("uncompressed:1") && o.codec == "zstd","codec is now " << o.codec);
+    ASSERT("  Codecs without levels reset the level",o.setCodec("snappy") && o.codec == "snappy" && o.level == 0,
+      o.codec << ":" << o.level);
+    unsigned known = 0;
+    for(unsigned i = 0; i < N_PARQUET_PRESETS; ++i) {
+      known += o.setPreset(PARQUET_PRESETS[i]);
+    }
+    ASSERT("Every preset is known",known == N_PARQUET_PRESETS,
+      known << " of " << N_PARQUET_PRESETS << " presets known");
+    ASSERT("Presets replace every option",o.setPreset("legacy") && o.codec == "uncompressed" && o.level == 0,
+      o.codec << ":" << o.level);
+    o.setPlainColumns("seed,,pos_x_post");
+    ASSERT("Plain columns are split",o.plain_columns.size() == 2 && o.dictionary,
+      o.plain_columns.size() << " plain columns");
+    o.setPlainColumns("all");
+    ASSERT("  'all' disables every dictionary",o.plain_columns.empty() && !o.dictionary,
+      o.plain_columns.size() << " plain columns");
+  return 0;
+}
+
+int testOutputSinks() {
+  TSUITE("Output Sinks");
+    OutputSink sink;
+    sink.dir     = (std::filesystem::temp_directory_path() / "slippc-sink-test").string();
+    sink.pattern = "{replay}/{name}.{replay}";
+    sink.replay  = "game";
+    std::string path = sink.path("frames.parquet");
+    ASSERT("Templates name every file",path == (PATH(sink.dir) / "game" / "frames.parquet.game").string(),
+      "got " << path);
+    ASSERT("  Template directories are created",std::filesystem::is_directory(PATH(sink.dir) / "game"),
+      (PATH(sink.dir) / "game") << " is not a directory");
+    std::filesystem::remove_all(sink.dir);
+    sink.replay = "{replay}x";
+    std::string file = sink.file("{name}.parquet");
+    ASSERT("  Field values may contain fields",file == "{replay}x/{name}.parquet.{replay}x",
+      "got " << file);
+
+    //Two parsers alive at once must ask their own sinks for every file
+    std::vector<std::string> opened[2];
+    slip::Parser* p[2];
+    Analysis*     a[2];
+    unsigned loaded = 0;
+    for (const f_entry & entry : f_iter(PATH(TESTDIR) / PATH(STANDARDDIR))) {
+      if (loaded == 2) {
+        break;
+      }
+      p[loaded] = new slip::Parser(_debug);
+      if (!p[loaded]->load(entry.path().string().c_str())) {
+        delete p[loaded];
+        continue;
+      }
+      a[loaded] = p[loaded]->analyze();
+      ++loaded;
+    }
+    for(unsigned i = 0; i < loaded; ++i) {
+      OutputSink s;
+      s.streams = [&opened,i](const std::string& name) -> arrow::Result<std::shared_ptr<arrow::io::OutputStream>> {
+        opened[i].push_back(name);
+        return arrow::io::BufferOutputStream::Create();
+      };
+      p[i]->save(s, "test.slp", true);
+      a[i]->save(s);
+    }
+    for(unsigned i = 0; i < loaded; ++i) {
+      unsigned missing = 0;
+      for (const char* name : { "settings.json", "match-settings.jsonl", "player-settings.jsonl", "frames.parquet",
+          "items.parquet", "stats.json", "attacks.parquet", "punishes.parquet", "dynamics.parquet" }) {
+        missing += (std::find(opened[i].begin(),opened[i].end(),name) == opened[i].end());
+      }
+      ASSERT("Replay "+std::to_string(i)+" writes every file through its sink",missing == 0,
+        missing << " files not opened through the sink");
+      delete a[i];
+      delete p[i];
+    }
+
+    //Frames written while parsing go to the stream sink
+    std::vector<std::string> streamed;
+    slip::Parser *sp = new slip::Parser(_debug);
+    OutputSink s;
+    s.streams = [&streamed](const std::string& name) -> arrow::Result<std::shared_ptr<arrow::io::OutputStream>> {
+      streamed.push_back(name);
+      return arrow::io::BufferOutputStream::Create();
+    };
+    sp->setFrameStreaming(true);
+    sp->setStreamSink(s);
+    for (const f_entry & entry : f_iter(PATH(TESTDIR) / PATH(STANDARDDIR))) {
+      if (sp->load(entry.path().string().c_str())) {
+        break;
+      }
+    }
+    ASSERT("Streamed frames are opened through the stream sink",streamed.size() == 1 && streamed[0] == "frames.parquet",
+      streamed.size() << " files opened");
+    delete sp;
+  return 0;
+}
+
+int testBatchedOutput() {
+  TSUITE("Batched Output");
+    //A 1-byte target starts a new file after every append, so each replay gets its own part
+    std::vector<std::string> opened;
+    OutputSink sink;
+    sink.streams = [&opened](const std::string& name) -> arrow::Result<std::shared_ptr<arrow::io::OutputStream>> {
+      opened.push_back(name);
+      return arrow::io::BufferOutputStream::Create();
+    };
+    for (uint64_t target : { uint64_t(1), uint64_t(0) }) {
+      ParquetBatch batch(sink, ParquetOptions(), target);
+      slip::Parser *p = new slip::Parser(_debug);
+      p->setParquetBatch(&batch);
+      p->setFrameStreaming(target == 0);  //Also cover frames written while parsing
+      opened.clear();
+      unsigned replays = 0;
+      uint64_t rows    = 0;
+      for (const f_entry & entry : f_iter(PATH(TESTDIR) / PATH(STANDARDDIR))) {
+        if (!p->load(entry.path().string().c_str())) {
+          continue;  //Covered by the sanity checks
+        }
+        const SlippiReplay* r = p->replay();
+        for(unsigned pnum = 0; pnum < 8; ++pnum) {
+          rows += (r->player[pnum].player_type != 3 && !r->player[pnum].cols.empty()) ? r->frame_count : 0;
+        }
+        p->save(sink, "test.slp", true);
+        ++replays;
+      }
+      ASSERT(std::string(target ? "Rolling" : "Single")+" batch holds every replay's frames",batch.frames.rows() == rows,
+        batch.frames.rows() << " rows written of " << rows);
+      ASSERT(target ? "  Files roll over at the target size" : "  Everything shares one file",
+        batch.frames.files() == (target ? replays : std::min(replays,1u)),
+        batch.frames.files() << " frames files for " << replays << " replays");
+      unsigned named = 0;
+      for (const std::string& name : opened) {
+        char expected[32];
+        snprintf(expected, sizeof(expected), target ? "frames-%05u.parquet" : "frames.parquet", named);
+        named += (name == expected);
+      }
+      ASSERT("  Files are numbered only when rolling over",named == batch.frames.files(),
+        named << " of " << batch.frames.files() << " frames files named as expected");
+      p->setParquetBatch(nullptr);
+      ASSERT("  Batch closes cleanly",batch.close().ok() && !batch.frames.isOpen(),
+        "could not close the batch");
+      delete p;
+    }
+  return 0;
+}
+
+int testSortedFrames() {
+  TSUITE("Sorted Frames");
+    const uint32_t budget = 1000;  //Rows per row group
+    for (const f_entry & entry : f_iter(PATH(TESTDIR) / PATH(STANDARDDIR))) {
+      std::string name = entry.path().stem().string();
+      slip::Parser *p = new slip::Parser(_debug);
+      ParquetOptions o;
+      OutputSink sink;
+      o.row_group_rows = budget;
+      o.sorted         = true;
+      sink.dir         = std::filesystem::temp_directory_path().string();
+      p->setParquetOptions(o);
+      p->setFrameStreaming(true);
+      p->setStreamSink(sink);
+      if (!p->load(entry.path().string().c_str())) {
+        delete p;
+        continue;  //Covered by the sanity checks
+      }
+      const SlippiReplay* r = p->replay();
+      const PlayerFrameWriter* w = p->frameWriter();
+      unsigned groups = 0;
+      for(unsigned pnum = 0; pnum < 8; ++pnum) {
+        if (!r->player[pnum].cols.empty() && r->player[pnum].player_type != 3) {
+          groups += (r->frame_count+budget-1)/budget;
+        }
+      }
+      ASSERT(name+" writes each player's frames in its own row groups",w->rowGroups() == std::max(groups,1u),
+        w->rowGroups() << " row groups, expected " << groups);
+      ASSERT("  Row groups stay within budget",w->peakRows() <= budget && w->written() == r->frame_count,
+        w->peakRows() << " rows held at once; " << w->written() << " of " << r->frame_count << " frames written");
+      delete p;
+    }
+  return 0;
+}
+
+int testHivePartitions() {
+  TSUITE("Hive Partitions");
+    OutputSink sink;
+    sink.pattern = HIVE_PATTERN;
+    sink.replay  = "game";
+    ASSERT("Part numbers aren't part of the table",sink.file("frames-00012.parquet") == "frames/game_frames-00012.parquet",
+      "got " << sink.file("frames-00012.parquet"));
+
+    for (const f_entry & entry : f_iter(PATH(TESTDIR) / PATH(STANDARDDIR))) {
+      std::string name = entry.path().stem().string();
+      slip::Parser *p = new slip::Parser(_debug);
+      if (!p->load(entry.path().string().c_str())) {
+        delete p;
+        continue;  //Covered by the sanity checks
+      }
+      const SlippiReplay* r = p->replay();
+      std::string partition = r->partition();
+      std::string stage     = "stage=" + std::to_string(r->stage) + "/date=";
+      size_t chars          = partition.find("/chars=");
+      std::vector<unsigned> ids;
+      std::stringstream ss(chars == std::string::npos ? "" : partition.substr(chars+7));
+      for (std::string id; std::getline(ss,id,'-'); ) {
+        ids.push_back(atoi(id.c_str()));
+      }
+      ASSERT(name+" partitions by stage, date, and characters",partition.compare(0,stage.size(),stage) == 0 && chars != std::string::npos,
+        "got " << partition);
+      ASSERT("  Characters are listed in order",!ids.empty() && std::is_sorted(ids.begin(),ids.end()),
+        "got " << partition.substr(chars == std::string::npos ? 0 : chars));
+
+      //Every file lands in the replay's partition, and the manifest lists each table once
+      PartitionManifest manifest;
+      std::vector<std::string> opened;
+      sink.partition = partition;
+      sink.manifest  = &manifest;
+      sink.streams   = [&opened](const std::string& file) -> arrow::Result<std::shared_ptr<arrow::io::OutputStream>> {
+        opened.push_back(file);
+        return arrow::io::BufferOutputStream::Create();
+      };
+      p->save(sink, "test.slp", true);
+      p->save(sink, "test.slp", true);
+      unsigned outside = 0;
+      for (const std::string& file : opened) {
+        outside += (file.find("/" + partition + "/game_") == std::string::npos);
+      }
+      ASSERT("  Files are written under the partition",!opened.empty() && outside == 0,
+        outside << " of " << opened.size() << " files outside " << partition);
+      std::string lines = manifest.asJsonl();
+      ASSERT("  Manifest lists each table's partition once",manifest.size()*2 == opened.size()
+        && lines.find("\"stage\":\"" + std::to_string(r->stage) + "\"") != std::string::npos,
+        manifest.size() << " partitions for " << opened.size() << " files opened");
+      delete p;
+    }
+  return 0;
+}
+
+//Run the slippc binary with the given arguments, returning its exit status
+int runSlippc(const std::string& args) {
+  std::string cmd = "\"" + SLIPPC + "\" " + args;
+#ifdef _WIN32
+  return std::system(cmd.c_str());
+#else
+  int status = std::system((cmd + " > /dev/null 2>&1").c_str());
+  return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#endif
+}
+
+int testCommandLine() {
+  TSUITE("Command Line");
+    if (!std::filesystem::exists(SLIPPC)) {
+      SUGGEST("slippc has been built",false,"build it with `make` to run the command line tests");
+      return 0;
+    }
+
+    //Copy the test replays somewhere outside the temp directory, so inputs can't be found by accident
+    std::error_code ec;
+    PATH tmp = std::filesystem::temp_directory_path();
+    PATH in  = std::filesystem::absolute(PATH(CLIDIR));
+    PATH out = tmp / PATH("slippc-cli-test");
+    std::filesystem::remove_all(in,ec);
+    std::filesystem::remove_all(out,ec);
+    std::filesystem::create_directories(in,ec);
+    std::vector<std::string> names;
+    for (const f_entry & entry : f_iter(PATH(TESTDIR) / PATH(STANDARDDIR))) {
+      if (entry.path().extension() == ".slp") {
+        std::filesystem::copy_file(entry.path(), in / entry.path().filename(), ec);
+        names.push_back(entry.path().stem().string());
+      }
+    }
+    ASSERT("Input directory is outside the temp directory",!names.empty()
+      && in.string().compare(0,tmp.string().size(),tmp.string()) != 0,
+      names.size() << " replays copied to " << in.string());
+    BAILONFAIL(0);
+
+    //Each replay's files go in their own subdirectory
+    ASSERT("Directory run succeeds",runSlippc("-i \"" + in.string() + "\" -j \"" + (out / "plain").string() + "\"") == 0,
+      "slippc failed on " << in.string());
+    unsigned missing = 0;
+    for (const std::string& name : names) {
+      missing += !std::filesystem::exists(out / "plain" / name / "frames.parquet");
+      missing += !std::filesystem::exists(out / "plain" / name / "settings.json");
+    }
+    ASSERT("  Every replay is written",missing == 0,
+      missing << " files missing under " << (out / "plain").string());
+
+    //Shared Parquet files with -m
+    ASSERT("Batched directory run succeeds",runSlippc("-i \"" + in.string() + "\" -j \"" + (out / "batch").string() + "\" -m 64") == 0,
+      "slippc -m failed on " << in.string());
+    ASSERT("  Frames are written to a shared file",std::filesystem::exists(out / "batch" / "frames-00000.parquet"),
+      "no frames-00000.parquet under " << (out / "batch").string());
+
+    //Hive-partitioned files with -H
+    ASSERT("Partitioned directory run succeeds",runSlippc("-i \"" + in.string() + "\" -j \"" + (out / "hive").string() + "\" -H") == 0,
+      "slippc -H failed on " << in.string());
+    ASSERT("  Partition manifest is written",std::filesystem::exists(out / "hive" / "partitions.jsonl")
+      && std::filesystem::is_directory(out / "hive" / "frames"),
+      "no partitions.jsonl or frames/ under " << (out / "hive").string());
+
+    std::filesystem::remove_all(in,ec);
+    std::filesystem::remove_all(out,ec);
+  return 0;
+}
+
+int testRowGroupStreaming() {
+  TSUITE("Row Group Streaming");
+    const uint32_t budget = 1000;  //Rows per row group
+    for (const f_entry & entry : f_iter(PATH(TESTDIR) / PATH(STANDARDDIR))) {
+      std::string path = entry.path().string();
+      std::string name = entry.path().stem().string();
+
+      //Snapshot every frame as it's emitted, to check it didn't change afterwards
+      std::vector<SlippiFrame> seen[8];
+      uint32_t next = 0, ordered = 1, read_at_first = 0;
+      slip::Parser *p = new slip::Parser(_debug);
+      ParquetOptions o;
+      o.row_group_rows = budget;
+      OutputSink sink;
+      sink.dir = std::filesystem::temp_directory_path().string();
+      p->setParquetOptions(o);
+      p->setFrameStreaming(true);
+      p->setStreamSink(sink);
+      p->setFrameCallback([&](const SlippiReplay &r, uint32_t f) {
+        ordered &= (f == next++);
+        if (f == 0) {
+          read_at_first = r.frame_count;  //Frames read so far when the first one was emitted
+        }
+        for(unsigned pnum = 0; pnum < 8; ++pnum) {
+          if (!r.player[pnum].cols.empty()) {
+            seen[pnum].push_back(r.player[pnum].cols.row(f));
+          }
+        }
+      });
+      if (!p->load(path.c_str())) {
+        delete p;
+        continue;  //Covered by the sanity checks
+      }
+      const SlippiReplay* r = p->replay();
+      unsigned players = 0, mismatches = 0;
+      for(unsigned pnum = 0; pnum < 8; ++pnum) {
+        if (r->player[pnum].cols.empty() || r->player[pnum].player_type == 3) {
+          continue;
+        }
+        ++players;
+        for(unsigned f = 0; f < seen[pnum].size() && f < r->frame_count; ++f) {
+          mismatches += !framesMatch(seen[pnum][f],r->player[pnum].cols.row(f));
+        }
+      }
+      const PlayerFrameWriter* w = p->frameWriter();
+      uint32_t per_group = std::max(budget/std::max(players,1u),1u);
+      ASSERT(name+" emits every frame once, in order",ordered && next == r->frame_count,
+        next << " frames emitted of " << r->frame_count);
+      ASSERT("  Frames are emitted while parsing",read_at_first < r->frame_count,
+        read_at_first << " frames were read before the first was emitted");
+      ASSERT("  Emitted frames are final",mismatches == 0,
+        mismatches << " frames changed after being emitted");
+      ASSERT("  Writer wrote every frame",w->written() == r->frame_count && !w->isOpen(),
+        w->written() << " frames written of " << r->frame_count);
+      ASSERT("  Row groups stay within budget",w->peakRows() <= budget,
+        w->peakRows() << " rows held at once");
+      ASSERT("  Row groups are full until the last",w->rowGroups() == (r->frame_count+per_group-1)/per_group,
+        w->rowGroups() << " row groups for " << r->frame_count << " frames");
+      delete p;
+    }
+  return 0;
+}
+
+int testNoReplayCopies() {
+  TSUITE("No Replay Copies");
+    static_assert(!std::is_copy_constructible<SlippiReplay>::value, "Replays should only be read through views");
+    for (const f_entry & entry : f_iter(PATH(TESTDIR) / PATH(STANDARDDIR))) {
+      std::string path = entry.path().string();
+      std::string name = entry.path().stem().string();
+      slip::Parser *p = new slip::Parser(_debug);
+      if (!p->load(path.c_str())) {
+        delete p;
+        continue;  //Covered by the sanity checks
+      }
+
+      //A copy of the replay would have to duplicate each of its containers
+      const SlippiReplay* r = p->replay();
+      size_t replay_sized[3] = {
+        r->platform_changes.size()*sizeof(SlippiFodPlatformFrame),
+        r->items.size()*sizeof(SlippiItem),
+        r->item_index.slots.size()*sizeof(uint64_t),
+      };
+
+      __alloc_count  = 0;
+      __track_allocs = true;
+      std::string json = p->settingsAsJson() + p->playerSettingsAsJson() + p->matchSettingsAsJson(name);
+      Analysis* a = p->analyze();
+      __track_allocs = false;
+
+      //A copy allocates all of the containers at once, so count the fewest matches
+      unsigned copies = 0;
+      bool     first  = true;
+      for (size_t bytes : replay_sized) {
+        if (bytes == 0) {
+          continue;
+        }
+        unsigned matches = 0;
+        for (unsigned i = 0; i < __alloc_count; ++i) {
+          matches += (__alloc_sizes[i] == bytes);
+        }
+        copies = first ? matches : std::min(copies,matches);
+        first  = false;
+      }
+      ASSERT(name+" output and analysis read the replay in place",copies == 0,
+        copies << " possible copies of the replay in " << __alloc_count << " allocations");
+
+      //Analysis reads frames straight from the columns, so nothing near a row per frame is allocated
+      size_t largest = 0;
+      for (unsigned i = 0; i < __alloc_count; ++i) {
+        largest = std::max(largest,__alloc_sizes[i]);
+      }
+      ASSERT("  Analysis doesn't gather frames into rows",largest < r->frame_count*sizeof(SlippiFrame),
+        "largest allocation was " << largest << " bytes for " << r->frame_count << " frames");
+      delete a;
+      delete p;
+    }
+  return 0;
+}
+
+int testSummaryParsing() {
+  TSUITE("Summary Parsing");
+    for (const f_entry & entry : f_iter(PATH(TESTDIR) / PATH(STANDARDDIR))) {
+      std::string path = entry.path().string();
+      std::string name = entry.path().stem().string();
+
+      slip::Parser *pf = new slip::Parser(_debug);
+      slip::Parser *ps = new slip::Parser(_debug);
+      ps->setSummaryOnly(true);
+      bool lf = pf->load(path.c_str());
+      bool ls = ps->load(path.c_str());
+      ASSERT(name+" parses in summary mode",lf == ls,
+        name << " parses " << (lf ? "fully" : "in summary mode") << " only");
+      if (lf && ls) {
+        ASSERT("  Frame data was skipped",ps->summarized(),
+          "Summary fell back to a full parse");
+        ASSERT("  Settings match",pf->settingsAsJson().compare(ps->settingsAsJson()) == 0,
+          "Settings JSON differs");
+        ASSERT("  Match settings match",pf->matchSettingsAsJson(name).compare(ps->matchSettingsAsJson(name)) == 0,
+          pf->matchSettingsAsJson(name) << " != " << ps->matchSettingsAsJson(name));
+        ASSERT("  Player settings match",pf->playerSettingsAsJson().compare(ps->playerSettingsAsJson()) == 0,
+          "Player settings JSON differs");
+      }
+      delete pf;
+      delete ps;
+    };
+  return 0;
+}
+
+int testStreaming() {
+  TSUITE("Streamed Parsing");
+    for (const f_entry & entry : f_iter(PATH(TESTDIR) / PATH(STANDARDDIR))) {
+      std::string path = entry.path().string();
+      std::string name = entry.path().stem().string();
+
+      std::ifstream in(path, std::ios::binary);
+      std::vector<char> buf((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+      slip::Parser *pf = new slip::Parser(_debug);
+      if (!pf->load(path.c_str())) {
+        delete pf;
+        continue;  //Not our problem here; covered by the sanity checks
+      }
+
+      //Feed the replay in uneven chunks, as a recording in progress would arrive
+      uint32_t next = 0, ordered = 1;
+      slip::Parser *ps = new slip::Parser(_debug);
+      ps->beginStream([&next,&ordered](const SlippiReplay &r, uint32_t f) {
+        if (f != next++) {
+          ordered = 0;
+        }
+      });
+      bool fed = true;
+      for(size_t pos = 0, chunk = 1; pos < buf.size() && fed; pos += chunk, chunk = (chunk*7+13) % 4099) {
+        chunk = std::min(chunk+1, buf.size()-pos);
+        fed = ps->feed(buf.data()+pos, chunk);
+      }
+      ASSERT(name+" streams without errors",fed && ps->endStream(),
+        name << " could not be streamed");
+      const SlippiReplay* rf = pf->replay();
+      const SlippiReplay* rs = ps->replay();
+      ASSERT("  Frame counts match",rf->frame_count == rs->frame_count,
+        rf->frame_count << " != " << rs->frame_count);
+      ASSERT("  Every frame emitted once, in order",ordered && next == rs->frame_count,
+        next << " frames emitted of " << rs->frame_count);
+      ASSERT("  Metadata matches",rf->metadata.compare(rs->metadata) == 0,
+        "Metadata differs");
+      unsigned mismatches = 0;
+      for(unsigned pnum = 0; pnum < 8 && rf->frame_count == rs->frame_count; ++pnum) {
+        if (rf->player[pnum].cols.empty()) {
+          continue;
+        }
+        for(unsigned f = 0; f < rf->frame_count; ++f) {
+          if (!framesMatch(rf->player[pnum].cols.row(f),rs->player[pnum].cols.row(f))) {
+            ++mismatches;
+          }
+        }
+      }
+      ASSERT("  Frame data matches",mismatches == 0,
+        mismatches << " frames differ");
+      delete pf;
+      delete ps;
+    };
+  return 0;
+}
+
 int testKnownFiles() {
   std::string known1 = (PATH(TESTDIR) / PATH(STANDARDDIR) / PATH(TSLPFILE)).string();
 
@@ -258,46 +1329,46 @@ int testKnownFiles() {
       "Port 4 played " << r->player[3].ext_char_id << " (" << CharExt::name[r->player[3].ext_char_id] << ")");
     ASSERT("Game played on Dream Land",r->stage == 28,
       "Game played on" << r->stage << " (" << Stage::name[r->stage] << ")");
-    ASSERT("Port 3's damage on frame 2345 = 9.4%",NEAR(r->player[2].frame[2345].percent_post,9.4f),
-      "Port 3's damage on frame 2345 = " << r->player[2].frame[2345].percent_post);
-    ASSERT("Port 4's damage on frame 2345 = 117.46%",NEAR(r->player[3].frame[2345].percent_post,117.46f),
-      "Port 4's damage on frame 2345 = " << r->player[3].frame[2345].percent_post);
-    ASSERT("Port 3's joystick x on frame 4444 = -0.975",NEAR(r->player[2].frame[4444].joy_x,-0.975f),
-      "Port 3's joystick x on frame 4444 = " << r->player[2].frame[4444].joy_x);
-    ASSERT("Port 4's joystick y on frame 4444 = 0",NEAR(r->player[3].frame[4444].joy_y,0.0f),
-      "Port 4's joystick y on frame 4444 = " << r->player[3].frame[4444].joy_y);
-    ASSERT("Port 3's y pos on frame 4444 = 0.0089",NEAR(r->player[2].frame[4444].pos_y_post,0.0089f),
-      "Port 3's y pos on frame 4444 = " << r->player[2].frame[4444].pos_y_post);
-    ASSERT("Port 4's x pos on frame 4444 = 0.0089",NEAR(r->player[3].frame[4444].pos_x_post,-22.0653),
-      "Port 4's x pos on frame 4444 = " << r->player[3].frame[4444].pos_x_post);
-    ASSERT("Port 3 has 3 stocks on frame 4444",r->player[2].frame[4444].stocks == 3,
-      "Port 3 has " << r->player[2].frame[4444].stocks << " stocks on frame 4444");
-    ASSERT("Port 4 has 3 stocks on frame 4444",r->player[3].frame[4444].stocks == 3,
-      "Port 4 has " << r->player[3].frame[4444].stocks << " stocks on frame 4444");
-    ASSERT("Port 3 is in action 'Turn' on frame 5000",r->player[2].frame[5000].action_post == 18,
-      "Port 3 is in action " << r->player[2].frame[5000].action_post << " = " << Action::name[r->player[2].frame[5000].action_post]);
-    ASSERT("Port 3 is in action 'DamageFlyLw' on frame 6000",r->player[2].frame[6000].action_post == 89,
-      "Port 3 is in action " << r->player[2].frame[6000].action_post << " = " << Action::name[r->player[2].frame[6000].action_post]);
-    ASSERT("Port 3 is in action 'DamageFlyRoll' on frame 7000",r->player[2].frame[7000].action_post == 91,
-      "Port 3 is in action " << r->player[2].frame[7000].action_post << " = " << Action::name[r->player[2].frame[7000].action_post]);
-    ASSERT("Port 3 is in action 'Catch' on frame 8000",r->player[2].frame[8000].action_post == 212,
-      "Port 3 is in action " << r->player[2].frame[8000].action_post << " = " << Action::name[r->player[2].frame[8000].action_post]);
-    ASSERT("Port 3 is in action 'AttackAirN' on frame 9000",r->player[2].frame[9000].action_post == 65,
-      "Port 3 is in action " << r->player[2].frame[9000].action_post << " = " << Action::name[r->player[2].frame[9000].action_post]);
-    ASSERT("Port 3 is in action 'EscapeN' on frame 10000",r->player[2].frame[10000].action_post == 350,
-      "Port 3 is in action " << r->player[2].frame[10000].action_post << " = " << Action::name[r->player[2].frame[10000].action_post]);
-    ASSERT("Port 4 is in action 'Fall' on frame 5000",r->player[3].frame[5000].action_post == 29,
-      "Port 4 is in action " << r->player[3].frame[5000].action_post << " = " << Action::name[r->player[3].frame[5000].action_post]);
-    ASSERT("Port 4 is in action 'AttackAirF' on frame 6000",r->player[3].frame[6000].action_post == 66,
-      "Port 4 is in action " << r->player[3].frame[6000].action_post << " = " << Action::name[r->player[3].frame[6000].action_post]);
-    ASSERT("Port 4 is in action 'KneeBend' on frame 7000",r->player[3].frame[7000].action_post == 24,
-      "Port 4 is in action " << r->player[3].frame[7000].action_post << " = " << Action::name[r->player[3].frame[7000].action_post]);
-    ASSERT("Port 4 is in action 'JumpF' on frame 8000",r->player[3].frame[8000].action_post == 25,
-      "Port 4 is in action " << r->player[3].frame[8000].action_post << " = " << Action::name[r->player[3].frame[8000].action_post]);
-    ASSERT("Port 4 is in action 'GuardSetOff' on frame 9000",r->player[3].frame[9000].action_post == 181,
-      "Port 4 is in action " << r->player[3].frame[9000].action_post << " = " << Action::name[r->player[3].frame[9000].action_post]);
-    ASSERT("Port 4 is in action 'JumpF' on frame 10000",r->player[3].frame[10000].action_post == 25,
-      "Port 4 is in action " << r->player[3].frame[10000].action_post << " = " << Action::name[r->player[3].frame[10000].action_post]);
+    ASSERT("Port 3's damage on frame 2345 = 9.4%",NEAR(r->player[2].cols.percent_post[2345],9.4f),
+      "Port 3's damage on frame 2345 = " << r->player[2].cols.percent_post[2345]);
+    ASSERT("Port 4's damage on frame 2345 = 117.46%",NEAR(r->player[3].cols.percent_post[2345],117.46f),
+      "Port 4's damage on frame 2345 = " << r->player[3].cols.percent_post[2345]);
+    ASSERT("Port 3's joystick x on frame 4444 = -0.975",NEAR(r->player[2].cols.joy_x[4444],-0.975f),
+      "Port 3's joystick x on frame 4444 = " << r->player[2].cols.joy_x[4444]);
+    ASSERT("Port 4's joystick y on frame 4444 = 0",NEAR(r->player[3].cols.joy_y[4444],0.0f),
+      "Port 4's joystick y on frame 4444 = " << r->player[3].cols.joy_y[4444]);
+    ASSERT("Port 3's y pos on frame 4444 = 0.0089",NEAR(r->player[2].cols.pos_y_post[4444],0.0089f),
+      "Port 3's y pos on frame 4444 = " << r->player[2].cols.pos_y_post[4444]);
+    ASSERT("Port 4's x pos on frame 4444 = 0.0089",NEAR(r->player[3].cols.pos_x_post[4444],-22.0653),
+      "Port 4's x pos on frame 4444 = " << r->player[3].cols.pos_x_post[4444]);
+    ASSERT("Port 3 has 3 stocks on frame 4444",r->player[2].cols.stocks[4444] == 3,
+      "Port 3 has " << r->player[2].cols.stocks[4444] << " stocks on frame 4444");
+    ASSERT("Port 4 has 3 stocks on frame 4444",r->player[3].cols.stocks[4444] == 3,
+      "Port 4 has " << r->player[3].cols.stocks[4444] << " stocks on frame 4444");
+    ASSERT("Port 3 is in action 'Turn' on frame 5000",r->player[2].cols.action_post[5000] == 18,
+      "Port 3 is in action " << r->player[2].cols.action_post[5000] << " = " << Action::name[r->player[2].cols.action_post[5000]]);
+    ASSERT("Port 3 is in action 'DamageFlyLw' on frame 6000",r->player[2].cols.action_post[6000] == 89,
+      "Port 3 is in action " << r->player[2].cols.action_post[6000] << " = " << Action::name[r->player[2].cols.action_post[6000]]);
+    ASSERT("Port 3 is in action 'DamageFlyRoll' on frame 7000",r->player[2].cols.action_post[7000] == 91,
+      "Port 3 is in action " << r->player[2].cols.action_post[7000] << " = " << Action::name[r->player[2].cols.action_post[7000]]);
+    ASSERT("Port 3 is in action 'Catch' on frame 8000",r->player[2].cols.action_post[8000] == 212,
+      "Port 3 is in action " << r->player[2].cols.action_post[8000] << " = " << Action::name[r->player[2].cols.action_post[8000]]);
+    ASSERT("Port 3 is in action 'AttackAirN' on frame 9000",r->player[2].cols.action_post[9000] == 65,
+      "Port 3 is in action " << r->player[2].cols.action_post[9000] << " = " << Action::name[r->player[2].cols.action_post[9000]]);
+    ASSERT("Port 3 is in action 'EscapeN' on frame 10000",r->player[2].cols.action_post[10000] == 350,
+      "Port 3 is in action " << r->player[2].cols.action_post[10000] << " = " << Action::name[r->player[2].cols.action_post[10000]]);
+    ASSERT("Port 4 is in action 'Fall' on frame 5000",r->player[3].cols.action_post[5000] == 29,
+      "Port 4 is in action " << r->player[3].cols.action_post[5000] << " = " << Action::name[r->player[3].cols.action_post[5000]]);
+    ASSERT("Port 4 is in action 'AttackAirF' on frame 6000",r->player[3].cols.action_post[6000] == 66,
+      "Port 4 is in action " << r->player[3].cols.action_post[6000] << " = " << Action::name[r->player[3].cols.action_post[6000]]);
+    ASSERT("Port 4 is in action 'KneeBend' on frame 7000",r->player[3].cols.action_post[7000] == 24,
+      "Port 4 is in action " << r->player[3].cols.action_post[7000] << " = " << Action::name[r->player[3].cols.action_post[7000]]);
+    ASSERT("Port 4 is in action 'JumpF' on frame 8000",r->player[3].cols.action_post[8000] == 25,
+      "Port 4 is in action " << r->player[3].cols.action_post[8000] << " = " << Action::name[r->player[3].cols.action_post[8000]]);
+    ASSERT("Port 4 is in action 'GuardSetOff' on frame 9000",r->player[3].cols.action_post[9000] == 181,
+      "Port 4 is in action " << r->player[3].cols.action_post[9000] << " = " << Action::name[r->player[3].cols.action_post[9000]]);
+    ASSERT("Port 4 is in action 'JumpF' on frame 10000",r->player[3].cols.action_post[10000] == 25,
+      "Port 4 is in action " << r->player[3].cols.action_post[10000] << " = " << Action::name[r->player[3].cols.action_post[10000]]);
     delete p;
 
   return 0;
@@ -333,6 +1404,26 @@ int runtests(int argc, char** argv) {
 
   testTestFiles();
   testKnownFiles();
+  testBufferLoading();
+  testParallelDecoding();
+  testExactSizing();
+  testFrameColumns();
+  testArenaReuse();
+  testItemTracking();
+  testAnalysisReuse();
+  testAttackPunishLists();
+  testDynamicIntervals();
+  testPlatformChanges();
+  testParquetOptions();
+  testRowGroupStreaming();
+  testOutputSinks();
+  testBatchedOutput();
+  testSortedFrames();
+  testHivePartitions();
+  testCommandLine();
+  testNoReplayCopies();
+  testSummaryParsing();
+  testStreaming();
   testCorruptFiles();
   testConsistencySanity();
   TESTRESULTS();
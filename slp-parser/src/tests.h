@@ -7,12 +7,12 @@
 #include "util.h"
 #include "parser.h"
 #include "analyzer.h"
-#include "compressor.h"
 
 #ifdef _WIN32
 #include <Windows.h> //sleep()
 #else
 #include <unistd.h> //sleep()
+#include <sys/wait.h> //WEXITSTATUS()
 #endif
 
 #include <algorithm>
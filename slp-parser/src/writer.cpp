@@ -0,0 +1,294 @@
+#include "writer.h"
+#include <arrow/io/file.h>
+#include <arrow/util/config.h>
+#include <parquet/arrow/writer.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+
+namespace slip {
+
+bool ParquetOptions::setCodec(const std::string& spec) {
+  static const std::pair<const char*,bool> names[] = {  //Codec, and whether it takes a level
+    { "uncompressed", false }, { "snappy", false }, { "gzip", true },
+    { "brotli",       true  }, { "zstd",   true  }, { "lz4",  false },
+  };
+  size_t colon     = spec.find(':');
+  std::string name = spec.substr(0,colon);
+  for (const auto& known : names) {
+    if (name.compare(known.first) != 0) {
+      continue;
+    }
+    long l = 0;
+    if (colon != std::string::npos) {
+      const char* start = spec.c_str()+colon+1;
+      char* end         = nullptr;
+      l                 = strtol(start,&end,10);
+      if (!known.second || end == start || *end != '\0' || l < 0 || l > INT32_MAX) {
+        return false;
+      }
+    }
+    codec = name;
+    level = int(l);
+    return true;
+  }
+  return false;
+}
+
+bool ParquetOptions::setPreset(const std::string& name) {
+  ParquetOptions o;
+  if (name.compare("legacy") == 0) {
+    o.codec          = "uncompressed";
+    o.row_group_rows = 1024;
+  } else if (name.compare("fast") == 0) {
+    //Defaults
+  } else if (name.compare("balanced") == 0) {
+    o.codec          = "zstd";
+    o.level          = 3;
+    o.row_group_rows = 4*PARQUET_ROW_GROUP_ROWS;
+  } else if (name.compare("small") == 0) {
+    o.codec          = "zstd";
+    o.level          = 9;
+    o.row_group_rows = 16*PARQUET_ROW_GROUP_ROWS;
+  } else {
+    return false;
+  }
+  *this = o;
+  return true;
+}
+
+void ParquetOptions::setPlainColumns(const std::string& list) {
+  plain_columns.clear();
+  for (size_t start = 0; start <= list.size(); ) {
+    size_t end = std::min(list.find(',',start),list.size());
+    std::string column = list.substr(start,end-start);
+    if (column.compare("all") == 0) {
+      dictionary = false;
+    } else if (!column.empty()) {
+      plain_columns.push_back(column);
+    }
+    start = end+1;
+  }
+}
+
+std::shared_ptr<parquet::WriterProperties> ParquetOptions::properties(const arrow::Schema* schema) const {
+  parquet::Compression::type compression = parquet::Compression::UNCOMPRESSED;
+  if      (codec.compare("snappy") == 0) { compression = parquet::Compression::SNAPPY; }
+  else if (codec.compare("gzip")   == 0) { compression = parquet::Compression::GZIP;   }
+  else if (codec.compare("brotli") == 0) { compression = parquet::Compression::BROTLI; }
+  else if (codec.compare("zstd")   == 0) { compression = parquet::Compression::ZSTD;   }
+  else if (codec.compare("lz4")    == 0) { compression = parquet::Compression::LZ4;    }
+
+  parquet::WriterProperties::Builder b;
+  b.compression(compression)
+    ->max_row_group_length(row_group_rows)
+    ->data_pagesize(page_bytes);
+  bool leveled = (compression == parquet::Compression::GZIP || compression == parquet::Compression::BROTLI
+    || compression == parquet::Compression::ZSTD);
+  if (level > 0 && leveled) {
+    b.compression_level(level);  //Other codecs refuse a level
+  }
+  if (dictionary) {
+    b.enable_dictionary();
+  } else {
+    b.disable_dictionary();
+  }
+  for (const std::string& column : plain_columns) {
+    b.disable_dictionary(column);
+  }
+  if (sorted) {
+    b.enable_statistics();
+#if ARROW_VERSION_MAJOR >= 12
+    b.enable_write_page_index();
+#endif
+#if ARROW_VERSION_MAJOR >= 14
+    std::vector<parquet::SortingColumn> sorting;
+    for (const char* column : PARQUET_SORT_COLUMNS) {
+      int index = schema ? schema->GetFieldIndex(column) : -1;
+      if (index >= 0) {
+        sorting.push_back({index, false, false});
+      }
+    }
+    if (sorting.size() == sizeof(PARQUET_SORT_COLUMNS)/sizeof(PARQUET_SORT_COLUMNS[0])) {
+      b.set_sorting_columns(sorting);  //Only tables with every sort column are written in that order
+    }
+#endif
+#if ARROW_VERSION_MAJOR >= 21
+    for (const char* column : PARQUET_BLOOM_COLUMNS) {
+      if (!schema || schema->GetFieldIndex(column) >= 0) {
+        b.enable_bloom_filter(column, {PARQUET_BLOOM_NDV, PARQUET_BLOOM_FPP});
+      }
+    }
+#endif
+  }
+  return b.build();
+}
+
+void PartitionManifest::add(const std::string& table, const std::string& location) {
+  _entries.insert({table,location});
+}
+
+std::string PartitionManifest::asJsonl() const {
+  std::stringstream ss;
+  for (const auto& e : _entries) {
+    ss << "{\"table\":\"" << e.first << "\",\"location\":\"" << e.second << "\"";
+    //Every key=value directory in the location is a partition key
+    for (size_t start = 0; start < e.second.size(); ) {
+      size_t end = std::min(e.second.find('/',start),e.second.size());
+      size_t eq  = e.second.find('=',start);
+      if (eq < end) {
+        ss << ",\"" << e.second.substr(start,eq-start) << "\":\"" << e.second.substr(eq+1,end-eq-1) << "\"";
+      }
+      start = end+1;
+    }
+    ss << "}\n";
+  }
+  return ss.str();
+}
+
+//Table a file belongs to: its name without the extension or an appender's part number
+static std::string tableName(const std::string& name) {
+  std::string table = name.substr(0,name.find('.'));
+  size_t dash = table.rfind('-');
+  if (dash != std::string::npos && dash+1 < table.size()
+    && table.find_first_not_of("0123456789",dash+1) == std::string::npos) {
+    table.resize(dash);
+  }
+  return table;
+}
+
+std::string OutputSink::file(const std::string& name) const {
+  const std::pair<std::string,std::string> fields[] = {
+    { "{name}",      name            },
+    { "{table}",     tableName(name) },
+    { "{replay}",    replay          },
+    { "{partition}", partition       },
+  };
+  std::string rel = pattern;
+  for (const auto& f : fields) {
+    for (size_t at = 0; (at = rel.find(f.first,at)) != std::string::npos; at += f.second.size()) {
+      rel.replace(at,f.first.size(),f.second);  //Resume past the value in case it contains the field
+    }
+  }
+  return std::filesystem::path(rel).lexically_normal().generic_string();  //An empty {partition} leaves "//"
+}
+
+std::string OutputSink::path(const std::string& name) const {
+  std::filesystem::path full = std::filesystem::path(dir) / file(name);
+  std::error_code ec;
+  std::filesystem::create_directories(full.parent_path(),ec);  //Failures show up when the file is opened
+  return full.string();
+}
+
+arrow::Result<std::shared_ptr<arrow::io::OutputStream>> OutputSink::open(const std::string& name) const {
+  if (manifest && !partition.empty()) {
+    manifest->add(tableName(name), std::filesystem::path(file(name)).parent_path().generic_string());
+  }
+  if (streams) {
+    return streams(file(name));
+  }
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::io::FileOutputStream> out,
+    arrow::io::FileOutputStream::Open(path(name)));
+  return std::static_pointer_cast<arrow::io::OutputStream>(out);
+}
+
+arrow::Status OutputSink::writeText(const std::string& name, const std::string& text) const {
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::io::OutputStream> out, open(name));
+  ARROW_RETURN_NOT_OK(out->Write(text.data(),text.size()));
+  return out->Close();
+}
+
+arrow::Status parquetWrite(const std::function<void()>& write) {
+  try {
+    write();
+  } catch (const parquet::ParquetException& e) {
+    std::cerr << "[ParquetException] " << e.what() << std::endl;
+    return arrow::Status::ExecutionError("ParquetException: ", e.what());
+  } catch (const std::exception& e) {
+    std::cerr << "[std::exception] " << e.what() << std::endl;
+    return arrow::Status::ExecutionError("std::exception: ", e.what());
+  } catch (...) {
+    std::cerr << "[Unknown error] during Parquet file write." << std::endl;
+    return arrow::Status::ExecutionError("Unknown error during Parquet write");
+  }
+  return arrow::Status::OK();
+}
+
+ParquetAppender::ParquetAppender(const OutputSink& sink, const std::string& name,
+  const ParquetOptions& o, uint64_t target_bytes)
+  : _sink(sink), _name(name), _options(o), _target_bytes(target_bytes) {
+}
+
+ParquetAppender::~ParquetAppender() {
+  close();
+}
+
+arrow::Status ParquetAppender::open(const arrow::Schema& schema) {
+  ARROW_RETURN_NOT_OK(close());
+  std::string file = _name + ".parquet";
+  if (_target_bytes > 0) {
+    char part[16];
+    snprintf(part, sizeof(part), "-%05u", _files);
+    file = _name + part + ".parquet";
+  }
+  return parquetWrite([&]() {
+    PARQUET_ASSIGN_OR_THROW(_out, _sink.open(file));
+    PARQUET_ASSIGN_OR_THROW(_file, parquet::arrow::FileWriter::Open(
+      schema, arrow::default_memory_pool(), _out, _options.properties(&schema)));
+    ++_files;
+  });
+}
+
+arrow::Status ParquetAppender::append(const arrow::Table& table, int64_t row_group_rows) {
+  if (not isOpen()) {
+    ARROW_RETURN_NOT_OK(open(*table.schema()));
+  }
+  int64_t chunk = (row_group_rows > 0) ? row_group_rows : _options.row_group_rows;
+  ARROW_RETURN_NOT_OK(parquetWrite([&]() {
+    PARQUET_THROW_NOT_OK(_file->WriteTable(table, std::max(chunk,int64_t(1))));
+  }));
+  _rows += table.num_rows();
+  if (_target_bytes == 0) {
+    return arrow::Status::OK();
+  }
+  //Row groups are flushed as they're written, so the stream position is the file's size so far
+  ARROW_ASSIGN_OR_RAISE(int64_t size, _out->Tell());
+  return (uint64_t(size) >= _target_bytes) ? close() : arrow::Status::OK();
+}
+
+arrow::Status ParquetAppender::close() {
+  if (not isOpen()) {
+    return arrow::Status::OK();
+  }
+  arrow::Status status = parquetWrite([&]() {
+    PARQUET_THROW_NOT_OK(_file->Close());
+    PARQUET_ASSIGN_OR_THROW(int64_t size, _out->Tell());
+    _bytes += size;
+    PARQUET_THROW_NOT_OK(_out->Close());
+  });
+  _file.reset();
+  _out.reset();
+  return status;
+}
+
+ParquetBatch::ParquetBatch(const OutputSink& sink, const ParquetOptions& o, uint64_t target_bytes)
+  : frames(sink,"frames",o,target_bytes), items(sink,"items",o,target_bytes),
+    platforms(sink,"platforms",o,target_bytes), attacks(sink,"attacks",o,target_bytes),
+    punishes(sink,"punishes",o,target_bytes), dynamics(sink,"dynamics",o,target_bytes) {
+}
+
+arrow::Status ParquetBatch::close() {
+  arrow::Status status;
+  for (ParquetAppender* a : { &frames, &items, &platforms, &attacks, &punishes, &dynamics }) {
+    arrow::Status closed = a->close();
+    if (status.ok()) {
+      status = closed;
+    }
+  }
+  return status;
+}
+
+}
@@ -0,0 +1,155 @@
+#ifndef WRITER_H_
+#define WRITER_H_
+
+#include <functional>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+#include <arrow/result.h>
+#include <arrow/status.h>
+
+// Options shared by every Parquet writer (player / item / platform frames and the analysis tables),
+//   the sink that decides where each of a replay's output files goes, and the appenders that
+//   write one or many replays' tables to those files
+
+namespace arrow {
+  class Schema;
+  class Table;
+  namespace io {
+    class OutputStream;
+  }
+}
+
+namespace parquet {
+  class WriterProperties;
+  namespace arrow {
+    class FileWriter;
+  }
+}
+
+namespace slip {
+
+const uint32_t PARQUET_ROW_GROUP_ROWS = 65536;   //Default rows per Parquet row group
+const uint32_t PARQUET_PAGE_BYTES     = 1 << 20; //Default target size of a Parquet data page (1 MiB)
+
+//How a Parquet file is compressed, encoded, and split into row groups and pages
+struct ParquetOptions {
+  std::string codec          = "snappy";               //Compression codec (uncompressed, snappy, gzip, brotli, zstd, or lz4)
+  int         level          = 0;                      //Compression level for gzip, brotli, and zstd (0 = the codec's default)
+  uint32_t    row_group_rows = PARQUET_ROW_GROUP_ROWS; //Most rows in a row group
+  uint32_t    page_bytes     = PARQUET_PAGE_BYTES;     //Target size of a data page
+  bool        dictionary     = true;                   //Whether columns are dictionary-encoded by default
+  std::vector<std::string> plain_columns = {};         //Columns that are never dictionary-encoded
+  bool        sorted         = false;                  //Write player frames sorted for lookups (see PARQUET_SORT_COLUMNS)
+
+  bool setCodec(const std::string& spec);        //Set the codec from "codec[:level]"; false if the codec is unknown, the level
+                                                 //  isn't a non-negative integer, or the codec doesn't take one
+  bool setPreset(const std::string& name);       //Replace every option with a named preset; false if unknown
+  void setPlainColumns(const std::string& list); //Comma-separated columns to write without dictionaries ("all" = every column)
+  std::shared_ptr<parquet::WriterProperties> properties(const arrow::Schema* schema = nullptr) const; //Parquet writer properties for these options (and a table's schema)
+};
+
+//In sorted mode, every row group of a table that has all of these columns is sorted by them,
+//  and says so in its metadata. Sorted files also get page indexes (per-page min / max) on
+//  every column and bloom filters on the columns lookups filter on, so an engine looking
+//  for one match's frame window or an action can skip nearly every page.
+const char* const PARQUET_SORT_COLUMNS[]  = { "match_id", "player_index", "frame_number" };
+const char* const PARQUET_BLOOM_COLUMNS[] = { "match_id", "action_post" };
+const int32_t     PARQUET_BLOOM_NDV       = 1024; //Distinct values a bloom filter is sized for (per column chunk)
+const double      PARQUET_BLOOM_FPP       = 0.01; //Bloom filter false positive rate
+
+//Named presets for ParquetOptions::setPreset(), from largest / cheapest to write to smallest
+const char* const PARQUET_PRESETS[] = {
+  "legacy",   //Uncompressed, 1024-row row groups (what every writer used to do)
+  "fast",     //Snappy, 64K-row row groups (the default)
+  "balanced", //ZSTD level 3, 256K-row row groups
+  "small",    //ZSTD level 9, 1M-row row groups
+};
+const unsigned N_PARQUET_PRESETS = sizeof(PARQUET_PRESETS)/sizeof(PARQUET_PRESETS[0]);
+
+const std::string HIVE_PATTERN           = "{table}/{partition}/{replay}_{name}"; //OutputSink pattern for a Hive-partitioned layout
+const std::string HIVE_DEFAULT_PARTITION = "__HIVE_DEFAULT_PARTITION__";         //Partition value Hive uses for a missing key
+
+//Hive partitions that files were written to (one entry per table and partition), so they
+//  can be registered with a query engine without listing the whole output
+class PartitionManifest {
+private:
+  std::set<std::pair<std::string,std::string>> _entries;  //(table, directory relative to the sink's dir)
+public:
+  void add(const std::string& table, const std::string& location);
+  inline size_t size() const { return _entries.size(); }
+  std::string asJsonl() const;  //One line per partition: table, location, and each key=value in the location
+};
+
+//Opens a file by its path relative to the sink's directory
+typedef std::function<arrow::Result<std::shared_ptr<arrow::io::OutputStream>>(const std::string& file)> StreamFactory;
+
+//Where a replay's output files go. Each file ("frames.parquet", "settings.json", ...) is written
+//  to dir/pattern, where the pattern's {name} is the file's name, {table} its name without the
+//  extension, {replay} the replay's name, and {partition} the replay's Hive partition (e.g.
+//  SlippiReplay::partition()), so parses sharing a directory get distinct files. A caller that
+//  wants the bytes somewhere else can supply its own streams instead.
+struct OutputSink {
+  std::string   dir       = ".";      //Directory every file is written under
+  std::string   pattern   = "{name}"; //File name template (may contain '/')
+  std::string   replay    = "";       //Name substituted for {replay}
+  std::string   partition = "";       //Path substituted for {partition} (key=value/key=value/...)
+  StreamFactory streams   = nullptr;  //If set, opens every file instead of the filesystem
+  PartitionManifest* manifest = nullptr; //If set, records the partition of every file opened
+
+  std::string file(const std::string& name) const; //Path of a file relative to dir
+  std::string path(const std::string& name) const; //Full path of a file, creating its directory if needed
+  arrow::Result<std::shared_ptr<arrow::io::OutputStream>> open(const std::string& name) const; //Open a file for writing
+  arrow::Status writeText(const std::string& name, const std::string& text) const; //Write a whole text file
+};
+
+//Run a Parquet write, turning anything it throws into an error status
+arrow::Status parquetWrite(const std::function<void()>& write);
+
+//Appends tables sharing one schema to a Parquet file through a single long-lived FileWriter.
+//  With a target size, the output is a run of files (name-00000.parquet, name-00001.parquet, ...)
+//  and a new one is started once the current one reaches the target; without one, everything
+//  goes to name.parquet. Each append() starts a new row group, so a row group never mixes replays.
+class ParquetAppender {
+private:
+  OutputSink     _sink;                  //Where files are opened
+  std::string    _name;                  //File name without the part number or extension
+  ParquetOptions _options;               //How files are compressed, encoded, and split into row groups
+  uint64_t       _target_bytes;          //Size at which to start the next file (0 = never)
+  std::shared_ptr<arrow::io::OutputStream>    _out;  //Current file (nullptr when none is open)
+  std::unique_ptr<parquet::arrow::FileWriter> _file; //Writer for the current file
+  unsigned       _files        = 0;      //Files started so far
+  uint64_t       _rows         = 0;      //Rows appended so far
+  uint64_t       _bytes        = 0;      //Bytes in files already finished
+public:
+  ParquetAppender(const OutputSink& sink, const std::string& name,
+    const ParquetOptions& o = ParquetOptions(), uint64_t target_bytes = 0);
+  ~ParquetAppender();
+  arrow::Status open(const arrow::Schema& schema);  //Start the next file (append() does this when needed)
+  arrow::Status append(const arrow::Table& table, int64_t row_group_rows = 0); //Write rows (0 = row groups from the options)
+  arrow::Status close();                            //Finish the current file, if any
+  inline bool     isOpen()  const { return _file != nullptr; }
+  inline unsigned files()   const { return _files; } //Files started so far
+  inline uint64_t rows()    const { return _rows; }  //Rows appended so far
+  inline uint64_t bytes()   const { return _bytes; } //Bytes in finished files
+  inline const ParquetOptions& options() const { return _options; }
+};
+
+//One appender per Parquet output, shared by every replay in a batch so that many
+//  replays end up in a few large files rather than one small file each
+struct ParquetBatch {
+  ParquetAppender frames;
+  ParquetAppender items;
+  ParquetAppender platforms;
+  ParquetAppender attacks;
+  ParquetAppender punishes;
+  ParquetAppender dynamics;
+
+  ParquetBatch(const OutputSink& sink, const ParquetOptions& o, uint64_t target_bytes);
+  arrow::Status close();  //Finish every file
+};
+
+}
+
+#endif /* WRITER_H_ */